@@ -1,33 +1,123 @@
 #include "ActiveObject.hpp"
 
 mutex ActiveObject::_outputMx;
+
+ActiveObject::ActiveObject(unsigned workers) : _tasks(), _chained(0), _started(chrono::steady_clock::now())
+{
+    for (unsigned i = 0; i < max(1u, workers); i++)
+    {
+        _workers.push_back(make_unique<Worker>());
+    }
+    // The workers are all in place before one can look at them
+    for (auto &worker : _workers)
+    {
+        worker->worker = thread(&ActiveObject::run, this, ref(*worker));
+    }
+}
+
 ActiveObject::~ActiveObject()
 {
-    // Let the worker thread know that it should stop
-    _done.store(true, memory_order_release);
-    // Wake up the worker thread
+    // Let the worker threads know that they should stop once the queue is drained
+    _tasks.close();
+    // Wait for the worker threads to finish the remaining tasks
+    for (auto &worker : _workers)
     {
-        lock_guard<mutex> lock(_mx);
-        _cv.notify_all();
+        worker->worker.join();
     }
-    // Wait for the worker thread to finish its previous task
-    _worker.join();
 }
 
-void ActiveObject::run()
+long long ActiveObject::elapsedNanos() const
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - _started).count();
+}
+
+void ActiveObject::run(Worker& self)
 {   
-  
+    bool shared = _workers.size() > 1;
     while (true)
     {
-        function<void()> task;
+        // Declared in the loop so a finished task releases what it captured before the next wait
+        Task task;
+        bool taken;
+        {
+            // The queue has a single consumer, so the workers take turns: the one holding the
+            // mutex parks on the queue and the others wait for the mutex
+            unique_lock<mutex> lock(_takeMx, defer_lock);
+            long long since = -1; // Start of the wait for a task, if the worker has to wait
+            if (shared && !lock.try_lock())
+            {
+                since = elapsedNanos();
+                self.idleSince.store(since, memory_order_relaxed);
+                lock.lock();
+            }
+            taken = _tasks.tryPop(task);
+            if (!taken)
+            {
+                if (since < 0)
+                {
+                    since = elapsedNanos();
+                    self.idleSince.store(since, memory_order_relaxed);
+                }
+                taken = _tasks.pop(task);
+            }
+            if (since >= 0)
+            {
+                // Only this thread writes the counters, so a load and a store are enough
+                self.idleNanos.store(self.idleNanos.load(memory_order_relaxed) + elapsedNanos() - since, memory_order_relaxed);
+                self.idleSince.store(-1, memory_order_relaxed);
+            }
+        }
+        if (!taken)
         {
-            unique_lock<mutex> lock(_mx);
-            _cv.wait(lock, [this] { return _done.load(memory_order_acquire) || !_tasks.empty(); });
-            if (_done.load(memory_order_acquire) && _tasks.empty()) return;
-            task = move(_tasks.front());
-            _tasks.pop();
+            // Closed and drained; the next worker finds the same
+            return;
         }
         task();
-    
+        self.executed.store(self.executed.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+}
+
+Task ActiveObject::keyFinished(size_t key)
+{
+    unique_lock<mutex> lock(_keysMx);
+    auto waiting = _keys.find(key);
+    if (waiting->second.empty())
+    {
+        _keys.erase(waiting);
+        return Task();
+    }
+    Task next = move(waiting->second.front());
+    waiting->second.pop_front();
+    return next;
+}
+
+size_t ActiveObject::executed() const
+{
+    size_t total = _chained.load(memory_order_relaxed);
+    for (const auto &worker : _workers)
+    {
+        total += worker->executed.load(memory_order_relaxed);
+    }
+    return total;
+}
+
+double ActiveObject::utilization() const
+{
+    long long elapsed = elapsedNanos();
+    if (elapsed <= 0)
+    {
+        return 0;
+    }
+    long long busy = 0;
+    for (const auto &worker : _workers)
+    {
+        long long idle = worker->idleNanos.load(memory_order_relaxed);
+        long long since = worker->idleSince.load(memory_order_relaxed);
+        if (since >= 0)
+        {
+            idle += elapsed - since;
+        }
+        busy += max(0LL, elapsed - idle);
     }
+    return static_cast<double>(busy) / (static_cast<double>(elapsed) * _workers.size());
 }
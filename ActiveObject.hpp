@@ -3,11 +3,14 @@
 
 #include <iostream>
 #include <thread>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+#include <vector>
 #include <mutex>
-#include <condition_variable>
-#include <queue>
 #include <functional>
-#include <atomic>
+#include "MPSCQueue.hpp"
+#include "Task.hpp"
 using namespace std;
 
 /**
@@ -18,12 +21,13 @@ using namespace std;
  * 
  * The class is templated to allow for any type of function to be enqueued.
  * 
- * The class is not thread-safe for the enqueuing of tasks, but is thread-safe
- * for the execution of tasks.
+ * Tasks can be enqueued from any number of threads and are executed by a pool of worker threads,
+ * one by default, in the order they were enqueued. The workers share one queue, so a long task
+ * only holds up its own worker. Tasks enqueued with the same key run one at a time, in order.
  * 
  * The components of this pattern are:
  * Proxy: The interface that clients use to interact with the Active Object (a.k.a. Pipeline server)
- * MethodRequest: The task that is enqueued and executed by the Active Object (a.k.a. function object Task)
+ * MethodRequest: The task that is enqueued and executed by the Active Object (a.k.a. Task)
  * Scheduler: The component that has a list of tasks to be executed by the Active Object (a.k.a. Task queue)
  * Servant: The component that actually executes the tasks (a.k.a. Worker thread)
  * Future: The result of the task execution (a.k.a. response to the client)
@@ -31,45 +35,139 @@ using namespace std;
 class ActiveObject
 {
 private:
-    queue<function<void()>> _tasks; // Task queue
-    mutex _mx; // Mutex to protect the task queue
-    condition_variable _cv; // Condition variable to wake up the worker thread
-    atomic<bool> _done; // Flag to signal the worker thread to stop
-    thread _worker; // Worker thread
+    /*
+    * Worker is one worker thread with the counters its utilization is computed from.
+    */
+    struct Worker
+    {
+        thread worker; // Worker thread
+        atomic<long long> idleNanos; // Time the worker spent waiting for a task, up to its last wake-up
+        atomic<long long> idleSince; // Start of the current wait for a task, -1 while the worker runs tasks
+        atomic<size_t> executed; // Number of tasks the worker has run
+
+        Worker() : idleNanos(0), idleSince(-1), executed(0) {}
+    };
+
+    MPSCQueue<Task> _tasks; // Task queue shared by the workers, lock-free for the enqueuing threads
+    mutex _takeMx; // Lets the workers take turns as the single consumer of the queue, unused with one worker
+    vector<unique_ptr<Worker>> _workers; // The worker threads
+    mutex _keysMx; // Mutex to protect the keys in flight
+    unordered_map<size_t, deque<Task>> _keys; // Keys with a task queued or running, and the tasks waiting behind it
+    atomic<size_t> _chained; // Number of waiting tasks run by the worker that finished the task before them
+    chrono::steady_clock::time_point _started; // Start of the worker threads, the origin of the idle times
     static mutex _outputMx; // Mutex to protect the output stream
 
    /*
     * @brief 
     * The worker thread function
-    * This function is the main loop of the worker thread.
-    * It waits for tasks to be enqueued and executes them.
+    * This function is the main loop of a worker thread.
+    * It takes the next task from the shared queue and executes it, parking only while the queue is empty.
+    * The clock is only read around the waiting, so a busy worker pays nothing for the utilization.
+    * @param self The counters of the worker.
     * @return void
    */
-    void run();
+    void run(Worker& self);
+
+    /*
+    * @brief Takes the next task waiting behind a finished task of the same key, or forgets the key if there is none.
+    * @param key The key of the finished task.
+    * @return Task The next task of the key, empty if there is none.
+    */
+    Task keyFinished(size_t key);
+
+    /*
+    * @brief Returns the time since the worker threads were started, in nanoseconds.
+    */
+    long long elapsedNanos() const;
 
 public:
-    ActiveObject() :_tasks(), _done(false), _worker(&ActiveObject::run, this) {}
+    /*
+    * @brief Starts the worker threads.
+    * @param workers The number of worker threads, at least one.
+    */
+    explicit ActiveObject(unsigned workers = 1);
 
     ~ActiveObject();
     
     /*
     * @brief
-    * This function enqueues a task to be executed by the worker thread.
+    * This function enqueues a task to be executed by a worker thread.
     * It is templated to allow for any type of function to be enqueued.
+    * Any number of threads may enqueue at once without taking a lock, and a worker thread
+    * is only woken up if it is parked. The task is moved into a Task, never copied, and
+    * enqueuing and running it allocate nothing unless it captures more than a Task keeps inline.
+    * With more than one worker, the next free worker takes the task, so tasks may finish in any order.
     * @param task The task to be enqueued
     * @return void
     */
     template <class F>
     void enqueue(F task)
     {   
-        // Lock the mutex to protect the task queue
-        unique_lock<mutex> lock(_mx);
-        // Move the task into the task queue
-        _tasks.emplace(task);
-        // Wake up the worker thread
-        _cv.notify_one();
+        _tasks.push(Task(move(task)));
     }
 
+    /*
+    * @brief
+    * This function enqueues a task that must run after every task enqueued earlier with the same key.
+    * Only one task of a key is queued or running at a time, and the ones behind it wait aside, without
+    * holding up a worker, until the worker that runs it takes them one after the other. Tasks with
+    * different keys run at the same time. With one worker every task already runs in order.
+    * @param key The key, for example the number of the session the task works on.
+    * @param task The task to be enqueued
+    * @return void
+    */
+    template <class F>
+    void enqueue(size_t key, F task)
+    {
+        if (_workers.size() == 1)
+        {
+            enqueue(move(task));
+            return;
+        }
+        Task work(move(task));
+        {
+            unique_lock<mutex> lock(_keysMx);
+            auto waiting = _keys.find(key);
+            if (waiting != _keys.end())
+            {
+                waiting->second.push_back(move(work));
+                return;
+            }
+            _keys.emplace(key, deque<Task>());
+        }
+        // The wrapper runs the tasks that queued up behind this one itself, which keeps the plain tasks
+        // free of any key. A worker never pushes them back, since it would park for good on a full queue
+        // that only the workers drain
+        _tasks.push(Task([this, key, work = move(work)]() mutable
+        {
+            work();
+            work.reset();
+            for (Task next = keyFinished(key); next; next = keyFinished(key))
+            {
+                next();
+                next.reset();
+                _chained.fetch_add(1, memory_order_relaxed);
+            }
+        }));
+    }
+
+    /*
+    * @brief Returns the number of worker threads.
+    */
+    unsigned workers() const { return static_cast<unsigned>(_workers.size()); }
+
+    /*
+    * @brief Returns the number of tasks the worker threads have run so far.
+    */
+    size_t executed() const;
+
+    /*
+    * @brief Returns the fraction of the time since the start that the worker threads spent running tasks.
+    * It is read while the workers run, so it is an estimate that can be off by the task in progress.
+    * @return double The utilization, between 0 and 1, averaged over the workers.
+    */
+    double utilization() const;
+
     static mutex& getOutputMutex() { return _outputMx; }
     
 };
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include "ActiveObject.hpp"
+using namespace std;
+
+/*
+    Microbenchmark of the ActiveObject task queue against the mutex and condition variable queue
+    of function<void()> it used before. Every workload enqueues tasks from one or more producer
+    threads, the way stage 0 of PipelineServer receives one task per uploaded edge, and is timed
+    until the worker has run all of them. The heap allocations made meanwhile are counted too.
+*/
+
+/*
+    LegacyActiveObject is the previous ActiveObject: every enqueue locks the mutex, pushes into a
+    queue<function<void()>> and notifies the condition variable, and the worker locks the same
+    mutex to pop.
+*/
+class LegacyActiveObject
+{
+    private:
+        queue<function<void()>> _tasks;
+        mutex _mx;
+        condition_variable _cv;
+        atomic<bool> _done;
+        thread _worker;
+
+        void run()
+        {
+            while (true)
+            {
+                function<void()> task;
+                {
+                    unique_lock<mutex> lock(_mx);
+                    _cv.wait(lock, [this] { return _done.load(memory_order_acquire) || !_tasks.empty(); });
+                    if (_done.load(memory_order_acquire) && _tasks.empty()) return;
+                    task = move(_tasks.front());
+                    _tasks.pop();
+                }
+                task();
+            }
+        }
+
+    public:
+        LegacyActiveObject() : _done(false), _worker(&LegacyActiveObject::run, this) {}
+
+        ~LegacyActiveObject()
+        {
+            _done.store(true, memory_order_release);
+            {
+                lock_guard<mutex> lock(_mx);
+                _cv.notify_all();
+            }
+            _worker.join();
+        }
+
+        template <class F>
+        void enqueue(F task)
+        {
+            unique_lock<mutex> lock(_mx);
+            _tasks.emplace(move(task));
+            _cv.notify_one();
+        }
+};
+
+const int TASKS = 2000000;
+
+// Every heap allocation of the program, counted by the replacement operator new below
+static atomic<size_t> heapAllocations(0);
+
+void* operator new(size_t size)
+{
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+/*
+    Result of one run: the sum the tasks computed, so the work cannot be optimized away, and the
+    heap allocations made between the first enqueue and the end of the last task.
+*/
+struct Run {
+    long long sum;
+    size_t allocations;
+};
+
+/*
+* @brief Enqueues TASKS tasks made by makeTask split over the producers and waits until the worker has run them all.
+* The producers start together once they are running, and a last task marks the queue as drained,
+* so only the steady state is timed and counted.
+*/
+template <class AO, class MakeTask>
+static Run produce(int producers, MakeTask makeTask)
+{
+    long long sum = 0; // Only touched by the worker thread
+    AO active;
+    atomic<bool> go(false);
+    atomic<bool> drained(false);
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&active, &sum, &go, &makeTask, p, producers]() {
+            while (!go.load(memory_order_acquire))
+            {
+                this_thread::yield();
+            }
+            for (int i = p; i < TASKS; i += producers)
+            {
+                active.enqueue(makeTask(sum, i));
+            }
+        });
+    }
+    size_t before = heapAllocations.load();
+    go.store(true, memory_order_release);
+    for (thread& t : threads)
+    {
+        t.join();
+    }
+    active.enqueue([&drained]() { drained.store(true, memory_order_release); });
+    while (!drained.load(memory_order_acquire))
+    {
+        this_thread::yield();
+    }
+    return {sum, heapAllocations.load() - before};
+}
+
+/*
+* @brief The smallest task: a reference and an int, which even function<void()> keeps inline.
+*/
+static auto smallTask(long long& sum, int i)
+{
+    return [&sum, i]() { sum += i; };
+}
+
+/*
+* @brief A task shaped like the pipeline stages of PipelineServer: seven references, a command string and four ints.
+*/
+static auto stageTask(long long& sum, int i)
+{
+    long long &a = sum, &b = sum, &c = sum, &d = sum, &e = sum, &f = sum;
+    string cmd = "Prim";
+    return [&sum, &a, &b, &c, &d, &e, &f, cmd, i, j = i, k = i, l = i]() {
+        sum += i + (j - k) * l + static_cast<long long>(cmd.size() - 4) + (&a != &b) + (&c != &d) + (&e != &f);
+    };
+}
+
+template <class F>
+static void report(const string& name, F run)
+{
+    auto start = chrono::steady_clock::now();
+    Run result = run();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "  " << name << ": " << ms << " ms, " << TASKS / ms / 1000 << " M tasks/s, "
+         << result.allocations << " heap allocations (sum " << result.sum << ")" << endl;
+}
+
+int main()
+{
+    for (int producers : {1, 2, 4, 8})
+    {
+        cout << TASKS << " small tasks from " << producers << (producers == 1 ? " producer" : " producers") << endl;
+        report("LegacyActiveObject", [producers]() { return produce<LegacyActiveObject>(producers, smallTask); });
+        report("ActiveObject", [producers]() { return produce<ActiveObject>(producers, smallTask); });
+        cout << TASKS << " pipeline stage sized tasks from " << producers << (producers == 1 ? " producer" : " producers") << endl;
+        report("LegacyActiveObject", [producers]() { return produce<LegacyActiveObject>(producers, stageTask); });
+        report("ActiveObject", [producers]() { return produce<ActiveObject>(producers, stageTask); });
+    }
+    cout << "Task heap allocations in total: " << Task::allocations() << endl;
+    return 0;
+}
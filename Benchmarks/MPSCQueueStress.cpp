@@ -0,0 +1,150 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include "MPSCQueue.hpp"
+using namespace std;
+
+/*
+    Stress test of the futex handshakes of MPSCQueue. Rings of capacity 1 to 32 are fed by 1 to 8 producers
+    that push in bursts and pause between them, so the consumer keeps running dry and parking in pop,
+    to be woken by wakeConsumer, while a consumer that stalls now and then fills the ring and parks the
+    producers in push, to be woken by tryPop. Every value carries its producer and sequence number, so
+    a value lost, duplicated or taken out of order is reported, and a watchdog reports a wake-up that
+    never comes as a stall instead of hanging.
+*/
+
+const int VALUES_PER_PRODUCER = 20000;
+const size_t CAPACITIES[] = {1, 2, 3, 4, 8, 16, 32};
+const int PRODUCERS[] = {1, 2, 4, 8};
+const int STALL_SECONDS = 10;
+
+atomic<uint64_t> progress(0); // Values taken so far by all the runs, watched by the watchdog
+
+/*
+* @brief Pushes VALUES_PER_PRODUCER values tagged with the producer, in bursts of 1 to 64 with a pause of up to
+* 200 microseconds, or just a yield, after each.
+*/
+static void produce(MPSCQueue<uint64_t>& queue, int producer, unsigned seed)
+{
+    mt19937 rng(seed);
+    int sent = 0;
+    while (sent < VALUES_PER_PRODUCER)
+    {
+        int burst = min(VALUES_PER_PRODUCER - sent, 1 + static_cast<int>(rng() % 64));
+        for (int i = 0; i < burst; i++, sent++)
+        {
+            queue.push(static_cast<uint64_t>(producer) << 32 | static_cast<uint64_t>(sent));
+        }
+        if (rng() % 4 == 0)
+        {
+            this_thread::yield();
+        }
+        else
+        {
+            this_thread::sleep_for(chrono::microseconds(rng() % 200));
+        }
+    }
+}
+
+/*
+* @brief Runs one configuration: takes every value with pop, stalling on about one value in 500 so the ring
+* fills, and closes the queue once the producers are done.
+* @return The number of values lost, duplicated or out of order, 0 if the run was clean.
+*/
+static int run(size_t capacity, int producers, unsigned seed)
+{
+    MPSCQueue<uint64_t> queue(capacity);
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back(produce, ref(queue), p, seed * 31 + p);
+    }
+    thread closer([&]()
+    {
+        for (thread& t : threads)
+        {
+            t.join();
+        }
+        queue.close();
+    });
+
+    mt19937 rng(seed);
+    vector<int> next(producers, 0);
+    int errors = 0;
+    uint64_t value = 0;
+    // pop takes values through tryPop, which alone frees slots for parked producers
+    while (queue.pop(value))
+    {
+        int producer = static_cast<int>(value >> 32);
+        int sequence = static_cast<int>(value & 0xffffffff);
+        if (producer >= producers || sequence != next[producer])
+        {
+            errors++;
+        }
+        else
+        {
+            next[producer]++;
+        }
+        progress.fetch_add(1, memory_order_relaxed);
+        if (rng() % 500 == 0)
+        {
+            this_thread::sleep_for(chrono::microseconds(300));
+        }
+    }
+    closer.join();
+    for (int p = 0; p < producers; p++)
+    {
+        errors += VALUES_PER_PRODUCER - next[p];
+    }
+    return errors;
+}
+
+int main()
+{
+    atomic<bool> finished(false);
+    thread watchdog([&finished]()
+    {
+        uint64_t seen = progress.load();
+        auto last = chrono::steady_clock::now();
+        while (!finished.load())
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            uint64_t now = progress.load();
+            if (now != seen)
+            {
+                seen = now;
+                last = chrono::steady_clock::now();
+            }
+            else if (chrono::steady_clock::now() - last > chrono::seconds(STALL_SECONDS))
+            {
+                cout << "Stalled: no value taken for " << STALL_SECONDS << " s, a wake-up was lost" << endl;
+                _Exit(1);
+            }
+        }
+    });
+
+    int failed = 0;
+    unsigned seed = 1;
+    for (size_t capacity : CAPACITIES)
+    {
+        for (int producers : PRODUCERS)
+        {
+            auto start = chrono::steady_clock::now();
+            int errors = run(capacity, producers, seed++);
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            cout << "  Capacity " << capacity << ", " << producers << (producers == 1 ? " producer: " : " producers: ")
+                 << ms << " ms, " << (errors == 0 ? "ok" : to_string(errors) + " values lost or out of order") << endl;
+            failed += errors != 0;
+        }
+    }
+    finished.store(true);
+    watchdog.join();
+
+    cout << (failed == 0 ? "All runs passed" : to_string(failed) + " runs failed") << endl;
+    return failed == 0 ? 0 : 1;
+}
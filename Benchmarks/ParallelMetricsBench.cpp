@@ -0,0 +1,238 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include "ParallelMetrics.hpp"
+using namespace std;
+
+/*
+    Benchmark of ParallelTreeMetrics against SequentialTreeMetrics, the reverse scan Tree uses on smaller trees, on
+    random, path, star and forest layouts of 4M positions split into 1 to 64 blocks. Every run is also checked against
+    the scan, and so is a sweep of small layouts, where the blocks are short and cut the subtrees at every depth.
+*/
+
+/*
+    Layout is a forest in the form Tree keeps it: positions in DFS preorder, one component after the other,
+    with the position of the parent (-1 for a root) and the weight of the edge to it.
+*/
+struct Layout {
+    vector<int> parentAt;
+    vector<int> weightAt;
+};
+
+/*
+    Metrics are the results both sides compute, compared exactly.
+*/
+struct Metrics {
+    long long diameter = 0;
+    __int128 pairSum = 0;
+    long long pairs = 0;
+
+    bool operator==(const Metrics& other) const
+    {
+        return diameter == other.diameter && pairSum == other.pairSum && pairs == other.pairs;
+    }
+};
+
+/*
+* @brief Lays out a forest given by the parent of every vertex, whose parents all come before it, in DFS preorder.
+* @return The layout, with random weights from 1 to 100.
+*/
+static Layout preorder(const vector<int>& parent, mt19937& rng)
+{
+    int n = static_cast<int>(parent.size());
+    vector<int> start(n + 1, 0);
+    for (int v = 0; v < n; v++)
+    {
+        if (parent[v] != -1)
+        {
+            start[parent[v] + 1]++;
+        }
+    }
+    for (int v = 0; v < n; v++)
+    {
+        start[v + 1] += start[v];
+    }
+    vector<int> children(start[n]);
+    vector<int> fill(start.begin(), start.end() - 1);
+    for (int v = 0; v < n; v++)
+    {
+        if (parent[v] != -1)
+        {
+            children[fill[parent[v]]++] = v;
+        }
+    }
+
+    uniform_int_distribution<int> weight(1, 100);
+    Layout layout;
+    layout.parentAt.reserve(n);
+    layout.weightAt.reserve(n);
+    vector<int> positionOf(n);
+    vector<int> stack;
+    for (int root = 0; root < n; root++)
+    {
+        if (parent[root] != -1)
+        {
+            continue;
+        }
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            int v = stack.back();
+            stack.pop_back();
+            positionOf[v] = static_cast<int>(layout.parentAt.size());
+            layout.parentAt.push_back(parent[v] == -1 ? -1 : positionOf[parent[v]]);
+            layout.weightAt.push_back(parent[v] == -1 ? 0 : weight(rng));
+            for (int c = start[v + 1]; c-- > start[v];)
+            {
+                stack.push_back(children[c]);
+            }
+        }
+    }
+    return layout;
+}
+
+/*
+* @brief Builds a random recursive tree, or a forest of them when roots is above 1, in DFS preorder.
+* @return The layout of n positions.
+*/
+static Layout randomLayout(int n, int roots, mt19937& rng)
+{
+    vector<int> parent(n, -1);
+    uniform_int_distribution<int> pickRoot(0, n - 1);
+    vector<bool> isRoot(n, false);
+    isRoot[0] = true;
+    for (int r = 1; r < roots; r++)
+    {
+        isRoot[pickRoot(rng)] = true;
+    }
+    int lastRoot = 0;
+    for (int v = 1; v < n; v++)
+    {
+        if (isRoot[v])
+        {
+            lastRoot = v;
+        }
+        else
+        {
+            // A parent after the last root keeps every component contiguous
+            parent[v] = uniform_int_distribution<int>(lastRoot, v - 1)(rng);
+        }
+    }
+    return preorder(parent, rng);
+}
+
+static Layout pathLayout(int n, mt19937& rng)
+{
+    vector<int> parent(n);
+    for (int v = 0; v < n; v++)
+    {
+        parent[v] = v - 1;
+    }
+    return preorder(parent, rng);
+}
+
+static Layout starLayout(int n, mt19937& rng)
+{
+    vector<int> parent(n, 0);
+    parent[0] = -1;
+    return preorder(parent, rng);
+}
+
+static Metrics sequentialScan(const Layout& layout)
+{
+    SequentialTreeMetrics sequential(layout.parentAt, layout.weightAt);
+    Metrics metrics;
+    metrics.diameter = sequential.diameter();
+    metrics.pairSum = sequential.pairDistanceSum();
+    metrics.pairs = sequential.pairCount();
+    return metrics;
+}
+
+static Metrics parallelScan(const Layout& layout, unsigned blocks)
+{
+    ParallelTreeMetrics parallel(layout.parentAt, layout.weightAt, blocks);
+    Metrics metrics;
+    metrics.diameter = parallel.diameter();
+    metrics.pairSum = parallel.pairDistanceSum();
+    metrics.pairs = parallel.pairCount();
+    return metrics;
+}
+
+/*
+* @brief Runs scan three times and reports the fastest run.
+* @return The result of the last run.
+*/
+template <class F>
+static Metrics report(const string& name, F scan)
+{
+    Metrics result;
+    double best = 0;
+    for (int run = 0; run < 3; run++)
+    {
+        auto start = chrono::steady_clock::now();
+        result = scan();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        best = run == 0 ? ms : min(best, ms);
+    }
+    cout << "  " << name << ": " << best << " ms" << endl;
+    return result;
+}
+
+const int N = 1 << 22;
+const unsigned BLOCKS[] = {1, 2, 3, 4, 8, 16, 32, 64};
+
+int main()
+{
+    mt19937 rng(42);
+    int mismatches = 0;
+
+    // Small layouts put block boundaries everywhere: inside chains, between siblings and between components
+    int checked = 0;
+    for (int seed = 0; seed < 25; seed++)
+    {
+        mt19937 small(seed);
+        int n = 1 + static_cast<int>(small() % 3000);
+        Layout layouts[] = {randomLayout(n, 1, small), pathLayout(n, small), starLayout(n, small), randomLayout(n, 1 + n / 50, small)};
+        for (const Layout& layout : layouts)
+        {
+            Metrics expected = sequentialScan(layout);
+            for (unsigned blocks = 1; blocks <= 64; blocks++)
+            {
+                checked++;
+                if (!(parallelScan(layout, blocks) == expected))
+                {
+                    mismatches++;
+                    cout << "Mismatch: seed " << seed << ", " << n << " positions, " << blocks << " blocks" << endl;
+                }
+            }
+        }
+    }
+    cout << "Small layouts: " << checked << " runs checked against SequentialTreeMetrics" << endl;
+
+    const pair<string, Layout> layouts[] = {
+        {"Random tree", randomLayout(N, 1, rng)},
+        {"Path", pathLayout(N, rng)},
+        {"Star", starLayout(N, rng)},
+        {"Forest of 1000 random trees", randomLayout(N, 1000, rng)},
+    };
+    for (const auto& entry : layouts)
+    {
+        const Layout& layout = entry.second;
+        cout << entry.first << " (" << layout.parentAt.size() << " positions)" << endl;
+        Metrics expected = report("SequentialTreeMetrics", [&]() { return sequentialScan(layout); });
+        for (unsigned blocks : BLOCKS)
+        {
+            string name = "ParallelTreeMetrics, " + to_string(blocks) + (blocks == 1 ? " block" : " blocks");
+            if (!(report(name, [&]() { return parallelScan(layout, blocks); }) == expected))
+            {
+                mismatches++;
+                cout << "  Mismatch with " << blocks << " blocks" << endl;
+            }
+        }
+    }
+
+    cout << (mismatches == 0 ? "All results match SequentialTreeMetrics" : to_string(mismatches) + " mismatches") << endl;
+    return mismatches == 0 ? 0 : 1;
+}
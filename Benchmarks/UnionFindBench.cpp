@@ -0,0 +1,133 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "UnionFind.hpp"
+using namespace std;
+
+/*
+    Microbenchmark of UnionFind against the recursive DSU that KruskalStrategy used before it.
+    Every workload runs on 10M elements.
+*/
+
+/*
+    LegacyDSU is the previous DSU: recursive find without path compression, union by rank,
+    and unite runs both finds again even when the caller already holds the roots.
+*/
+class LegacyDSU {
+    private:
+        vector<int> parent;
+        vector<int> rank;
+    public:
+        LegacyDSU(int n): parent(n, -1), rank(n, 0) {}
+
+        int find(int i)
+        {
+            if (parent[i] == -1)
+            {
+                return i;
+            }
+            return find(parent[i]);
+        }
+
+        void unite(int x, int y)
+        {
+            int s1 = find(x);
+            int s2 = find(y);
+            if (s1 != s2)
+            {
+                if (rank[s1] < rank[s2])
+                {
+                    parent[s1] = s2;
+                }
+                else if (rank[s1] > rank[s2])
+                {
+                    parent[s2] = s1;
+                }
+                else
+                {
+                    parent[s2] = s1;
+                    rank[s1]++;
+                }
+            }
+        }
+};
+
+const int N = 10000000;
+
+/*
+* @brief Runs the Kruskal access pattern (find both ends, unite the roots if they differ) over the given pairs.
+* @return The number of successful unions, so the work cannot be optimized away.
+*/
+template <class DS, class Unite>
+static int kruskalPattern(DS& ds, const vector<pair<int, int>>& pairs, Unite unite)
+{
+    int merged = 0;
+    for (const auto& p : pairs)
+    {
+        int x = ds.find(p.first);
+        int y = ds.find(p.second);
+        if (x != y)
+        {
+            unite(ds, x, y);
+            merged++;
+        }
+    }
+    return merged;
+}
+
+template <class F>
+static void report(const string& name, F run)
+{
+    auto start = chrono::steady_clock::now();
+    int result = run();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "  " << name << ": " << ms << " ms (" << result << " unions)" << endl;
+}
+
+int main()
+{
+    mt19937 rng(42);
+    uniform_int_distribution<int> pick(0, N - 1);
+
+    // Random pairs: the typical Kruskal workload on a sparse random graph
+    vector<pair<int, int>> randomPairs(3 * N);
+    for (auto& p : randomPairs)
+    {
+        p = {pick(rng), pick(rng)};
+    }
+
+    // Path pairs: (i, i + 1) in order, which builds long chains and then queries their tails
+    vector<pair<int, int>> pathPairs;
+    pathPairs.reserve(2 * N);
+    for (int i = 0; i + 1 < N; i++)
+    {
+        pathPairs.push_back({i, i + 1});
+    }
+    for (int i = 0; i < N; i++)
+    {
+        pathPairs.push_back({pick(rng), pick(rng)});
+    }
+
+    cout << "Random pairs (" << randomPairs.size() << " operations on " << N << " elements)" << endl;
+    report("LegacyDSU", [&]() {
+        LegacyDSU ds(N);
+        return kruskalPattern(ds, randomPairs, [](LegacyDSU& d, int x, int y) { d.unite(x, y); });
+    });
+    report("UnionFind", [&]() {
+        UnionFind ds(N);
+        return kruskalPattern(ds, randomPairs, [](UnionFind& d, int x, int y) { d.uniteRoots(x, y); });
+    });
+
+    cout << "Path then random queries (" << pathPairs.size() << " operations on " << N << " elements)" << endl;
+    report("LegacyDSU", [&]() {
+        LegacyDSU ds(N);
+        return kruskalPattern(ds, pathPairs, [](LegacyDSU& d, int x, int y) { d.unite(x, y); });
+    });
+    report("UnionFind", [&]() {
+        UnionFind ds(N);
+        return kruskalPattern(ds, pathPairs, [](UnionFind& d, int x, int y) { d.uniteRoots(x, y); });
+    });
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "DynamicMST.hpp"
+
+DynamicMST::DynamicMST(int V, const vector<Edge>& treeEdges): V(V), forest(2 * V), edgeOf(V), used(V, false), incident(V), mark(V, 0)
+{
+    freeNodes.reserve(V);
+    for (int node = 2 * V - 1; node >= V; node--)
+    {
+        freeNodes.push_back(node);
+    }
+    nodeOf.reserve(V);
+    for (const Edge& e : treeEdges)
+    {
+        linkEdge(e.src, e.dest, e.weight);
+    }
+}
+
+uint64_t DynamicMST::key(int u, int v)
+{
+    if (u > v)
+    {
+        swap(u, v);
+    }
+    return (static_cast<uint64_t>(u) << 32) | static_cast<uint32_t>(v);
+}
+
+void DynamicMST::linkEdge(int u, int v, int w)
+{
+    int node = freeNodes.back();
+    freeNodes.pop_back();
+    edgeOf[node - V] = {u, v, w};
+    used[node - V] = true;
+    nodeOf[key(u, v)] = node;
+    forest.setValue(node, w);
+    forest.link(u - 1, node);
+    forest.link(node, v - 1);
+    incident[u - 1].push_back(node);
+    incident[v - 1].push_back(node);
+}
+
+void DynamicMST::cutEdge(int node)
+{
+    const Edge& e = edgeOf[node - V];
+    forest.cut(e.src - 1, node);
+    forest.cut(node, e.dest - 1);
+    for (int x : {e.src - 1, e.dest - 1})
+    {
+        vector<int>& list = incident[x];
+        *find(list.begin(), list.end(), node) = list.back();
+        list.pop_back();
+    }
+    nodeOf.erase(key(e.src, e.dest));
+    used[node - V] = false;
+    freeNodes.push_back(node);
+}
+
+bool DynamicMST::insertEdge(int u, int v, int w)
+{
+    if (u < 1 || v < 1 || u > V || v > V || u == v)
+    {
+        return false;
+    }
+
+    // The new edge joins two trees of the forest: it is always part of the new forest
+    if (!forest.connected(u - 1, v - 1))
+    {
+        linkEdge(u, v, w);
+        return true;
+    }
+
+    // Otherwise it replaces the heaviest edge of the cycle it closes, if it is lighter
+    int heaviest = forest.pathMax(u - 1, v - 1);
+    if (heaviest < V || forest.getValue(heaviest) <= w)
+    {
+        return false;
+    }
+    cutEdge(heaviest);
+    linkEdge(u, v, w);
+    return true;
+}
+
+const vector<int>& DynamicMST::smallerSide(int u, int v)
+{
+    // Two fresh marks: stamp for the side of u, stamp + 1 for the side of v
+    stamp += 2;
+    queueU.clear();
+    queueV.clear();
+    queueU.push_back(u);
+    queueV.push_back(v);
+    mark[u] = stamp;
+    mark[v] = stamp + 1;
+
+    size_t headU = 0, headV = 0;
+    while (true)
+    {
+        // Advance each search by one vertex; the first search that runs out has found the smaller tree
+        for (int side = 0; side < 2; side++)
+        {
+            vector<int>& queue = side == 0 ? queueU : queueV;
+            size_t& head = side == 0 ? headU : headV;
+            if (head == queue.size())
+            {
+                return queue;
+            }
+            int x = queue[head++];
+            for (int node : incident[x])
+            {
+                const Edge& e = edgeOf[node - V];
+                int y = e.src - 1 == x ? e.dest - 1 : e.src - 1;
+                if (mark[y] != stamp + side)
+                {
+                    mark[y] = stamp + side;
+                    queue.push_back(y);
+                }
+            }
+        }
+    }
+}
+
+bool DynamicMST::removeEdge(const Graph& g, int u, int v)
+{
+    auto it = nodeOf.find(key(u, v));
+    if (it == nodeOf.end())
+    {
+        // Not a tree edge: the forest is still a minimum spanning forest
+        return false;
+    }
+    cutEdge(it->second);
+
+    // Every graph edge leaving the smaller side crosses the cut: graph edges never join two different trees
+    const vector<int>& side = smallerSide(u - 1, v - 1);
+    int sideMark = mark[side.front()];
+    const vector<vector<Edge>>& adj = g.getAdj();
+    const Edge* lightest = nullptr;
+    for (int x : side)
+    {
+        for (const Edge& e : adj[x])
+        {
+            if (mark[e.dest - 1] != sideMark && (lightest == nullptr || e.weight < lightest->weight))
+            {
+                lightest = &e;
+            }
+        }
+    }
+
+    if (lightest != nullptr)
+    {
+        linkEdge(lightest->src, lightest->dest, lightest->weight);
+    }
+    return true;
+}
+
+vector<Edge> DynamicMST::edges() const
+{
+    vector<Edge> result;
+    result.reserve(V - static_cast<int>(freeNodes.size()));
+    for (int i = 0; i < V; i++)
+    {
+        if (used[i])
+        {
+            result.push_back(edgeOf[i]);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,94 @@
+#ifndef DYNAMICMST_HPP
+#define DYNAMICMST_HPP
+#include <unordered_map>
+#include <cstdint>
+#include "Graph.hpp"
+#include "LinkCutTree.hpp"
+
+/*
+    DynamicMST keeps a minimum spanning forest up to date while edges are inserted into and removed from the graph.
+    The forest lives in a link-cut tree where every tree edge is an extra node holding its weight,
+    so the heaviest edge on the tree path between two vertices is found in O(log V).
+    Inserting (u, v, w) either links two trees, or replaces the heaviest edge of the u - v path
+    when w is lighter than it; both cases cost O(log V).
+    Removing a non-tree edge changes nothing. Removing a tree edge splits a tree in two, and only the
+    graph edges leaving the smaller of the two parts are searched for the lightest replacement.
+*/
+class DynamicMST {
+    private:
+        int V;                              // Number of vertices; nodes [0, V) are vertices, nodes [V, 2V) are edges
+        LinkCutTree forest;                 // Vertex and edge nodes of the current forest
+        vector<Edge> edgeOf;                // edgeOf[node - V] is the tree edge held by an edge node
+        vector<bool> used;                  // used[node - V] is true if the edge node is in the forest
+        vector<int> freeNodes;              // Edge nodes that are not in use
+        unordered_map<uint64_t, int> nodeOf; // Edge node of every tree edge, keyed by (min, max)
+        vector<vector<int>> incident;        // Edge nodes of the tree edges of every vertex (0-based)
+        vector<int> mark;                   // Side of every vertex during a repair, compared against stamp
+        int stamp = 0;                      // Marks left by earlier repairs are smaller than stamp
+        vector<int> queueU, queueV;         // Reusable BFS queues for the two sides of a removed edge
+
+        /*
+        * @brief This method will explore the two trees left after cutting the edge u - v, in lock step,
+        * until one of them is exhausted. The vertices of the smaller tree are left in its queue.
+        * @param u One endpoint of the removed tree edge (0-based).
+        * @param v The other endpoint of the removed tree edge (0-based).
+        * @return The queue holding every vertex of the smaller tree.
+        */
+        const vector<int>& smallerSide(int u, int v);
+
+        static uint64_t key(int u, int v);
+
+        /*
+        * @brief This method will add the edge (u, v, w) to the forest; u and v must be in different trees.
+        * @return void
+        */
+        void linkEdge(int u, int v, int w);
+
+        /*
+        * @brief This method will remove the tree edge held by the given edge node.
+        * @return void
+        */
+        void cutEdge(int node);
+
+    public:
+        /*
+        * @brief Builds the structure from an existing minimum spanning forest.
+        * @param V The number of vertices in the graph.
+        * @param treeEdges The edges of the minimum spanning forest, with 1-based vertices.
+        */
+        DynamicMST(int V, const vector<Edge>& treeEdges);
+
+        /*
+        * @brief This method will update the forest after the edge (u, v, w) was added to the graph.
+        * @param u The first vertex (1-based).
+        * @param v The second vertex (1-based).
+        * @param w The weight of the new edge.
+        * @return true if the forest changed, false if the new edge is not part of it.
+        */
+        bool insertEdge(int u, int v, int w);
+
+        /*
+        * @brief This method will repair the forest after the edge between u and v was removed from the graph g.
+        * @param g The graph, which must no longer contain the edge u - v.
+        * @param u The first vertex (1-based).
+        * @param v The second vertex (1-based).
+        * @return true if the forest changed, false if u - v was not a tree edge.
+        */
+        bool removeEdge(const Graph& g, int u, int v);
+
+        /*
+        * @brief This method will check if the edge between u and v is part of the forest.
+        * @return true if u - v is a tree edge.
+        */
+        bool contains(int u, int v) const { return nodeOf.count(key(u, v)) > 0; }
+
+        /*
+        * @brief This method will return the edges of the current forest.
+        * @return vector<Edge> The tree edges, with 1-based vertices.
+        */
+        vector<Edge> edges() const;
+
+        int getVerticesNumber() const { return V; }
+};
+
+#endif
@@ -1,5 +1,125 @@
 
 #include "Graph.hpp"
+#include <atomic>
+
+uint64_t EdgeIndex::makeKey(int u, int v)
+{
+    if (u > v)
+    {
+        swap(u, v);
+    }
+    return (static_cast<uint64_t>(u) << 32) | static_cast<uint32_t>(v);
+}
+
+size_t EdgeIndex::home(uint64_t key) const
+{
+    // splitmix64 finalizer, spreads the packed vertex ids over the whole table
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key & (table.size() - 1);
+}
+
+void EdgeIndex::grow()
+{
+    vector<Slot> old;
+    old.swap(table);
+    table.resize(old.empty() ? 16 : old.size() * 2);
+    for (const Slot& slot : old)
+    {
+        if (slot.key != 0)
+        {
+            size_t i = home(slot.key);
+            while (table[i].key != 0)
+            {
+                i = (i + 1) & (table.size() - 1);
+            }
+            table[i] = slot;
+        }
+    }
+}
+
+void EdgeIndex::reserve(size_t n)
+{
+    while (table.size() < 2 * n)
+    {
+        grow();
+    }
+}
+
+EdgeIndex::Slot* EdgeIndex::find(int u, int v)
+{
+    return const_cast<Slot*>(static_cast<const EdgeIndex*>(this)->find(u, v));
+}
+
+const EdgeIndex::Slot* EdgeIndex::find(int u, int v) const
+{
+    if (table.empty())
+    {
+        return nullptr;
+    }
+    uint64_t key = makeKey(u, v);
+    for (size_t i = home(key); table[i].key != 0; i = (i + 1) & (table.size() - 1))
+    {
+        if (table[i].key == key)
+        {
+            return &table[i];
+        }
+    }
+    return nullptr;
+}
+
+EdgeIndex::Slot* EdgeIndex::insert(int u, int v)
+{
+    // Keep the load factor at or below one half
+    if (2 * (count + 1) > table.size())
+    {
+        grow();
+    }
+    uint64_t key = makeKey(u, v);
+    size_t i = home(key);
+    while (table[i].key != 0)
+    {
+        i = (i + 1) & (table.size() - 1);
+    }
+    table[i].key = key;
+    count++;
+    return &table[i];
+}
+
+bool EdgeIndex::erase(int u, int v)
+{
+    Slot* slot = find(u, v);
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    // Backward-shift deletion: pull later entries of the probe run into the hole
+    size_t mask = table.size() - 1;
+    size_t hole = slot - table.data();
+    for (size_t i = (hole + 1) & mask; table[i].key != 0; i = (i + 1) & mask)
+    {
+        size_t h = home(table[i].key);
+        // The entry can move into the hole only if its home is not inside (hole, i]
+        if (((i - h) & mask) >= ((i - hole) & mask))
+        {
+            table[hole] = table[i];
+            hole = i;
+        }
+    }
+    table[hole] = Slot();
+    count--;
+    return true;
+}
+
+uint64_t Graph::nextVersion()
+{
+    static atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, memory_order_relaxed) + 1;
+}
 
 bool Graph::addEdge(int u, int v, int w)
 {   
@@ -9,50 +129,155 @@ bool Graph::addEdge(int u, int v, int w)
     }
     
     // Check if the edge already exists
-    for (const auto& edge : adj[u - 1]) {
-        if (edge.dest == v) {
-           
-            return false;
-        }
+    if (index.find(u, v) != nullptr) {
+        return false;
     }
     
-    // Add edge if it doesn't exist
+    // Add edge if it doesn't exist, and remember where its two entries live
+    EdgeIndex::Slot* slot = index.insert(u, v);
+    slot->posLo = static_cast<int>(adj[min(u, v) - 1].size());
+    slot->posHi = static_cast<int>(adj[max(u, v) - 1].size());
     adj[u - 1].push_back({u, v, w});
     adj[v - 1].push_back({v, u, w});
+    version = nextVersion();
     return true;
 }
 
-bool Graph::removeEdge(int u, int v)
+int Graph::addEdges(const vector<Edge>& edges)
 {
-    // Get the initial size of the adjacency lists
-    size_t initialSizeU = adj[u - 1].size();
-    size_t initialSizeV = adj[v - 1].size();
+    // Pair every valid edge with its (min, max) key and its position in the batch
+    vector<pair<uint64_t, int>> keys;
+    keys.reserve(edges.size());
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        int u = edges[i].src, v = edges[i].dest;
+        if (u < 1 || v < 1 || u > V || v > V || u == v)
+        {
+            continue;
+        }
+        uint64_t key = (static_cast<uint64_t>(min(u, v)) << 32) | static_cast<uint32_t>(max(u, v));
+        keys.push_back({key, static_cast<int>(i)});
+    }
 
+    // Sorting by (key, position) puts the first occurrence of every edge at the head of its run
+    sort(keys.begin(), keys.end());
+    vector<bool> accepted(edges.size(), false);
+    vector<int> degree(V, 0);
+    int added = 0;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        if (i > 0 && keys[i].first == keys[i - 1].first)
+        {
+            continue;
+        }
+        const Edge& e = edges[keys[i].second];
+        if (index.find(e.src, e.dest) != nullptr)
+        {
+            continue;
+        }
+        accepted[keys[i].second] = true;
+        degree[e.src - 1]++;
+        degree[e.dest - 1]++;
+        added++;
+    }
+
+    // Reserve everything up front, then build the lists in batch order
+    index.reserve(index.size() + added);
+    for (int u = 0; u < V; u++)
+    {
+        if (degree[u] > 0)
+        {
+            adj[u].reserve(adj[u].size() + degree[u]);
+        }
+    }
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        if (!accepted[i])
+        {
+            continue;
+        }
+        int u = edges[i].src, v = edges[i].dest, w = edges[i].weight;
+        EdgeIndex::Slot* slot = index.insert(u, v);
+        slot->posLo = static_cast<int>(adj[min(u, v) - 1].size());
+        slot->posHi = static_cast<int>(adj[max(u, v) - 1].size());
+        adj[u - 1].push_back({u, v, w});
+        adj[v - 1].push_back({v, u, w});
+    }
+    if (added > 0)
+    {
+        version = nextVersion();
+    }
+    return added;
+}
+
+void Graph::detach(int x, int pos)
+{
+    vector<Edge>& list = adj[x - 1];
+    if (pos != static_cast<int>(list.size()) - 1)
+    {
+        list[pos] = list.back();
+        // The moved entry is the edge {x, dest}; point its index slot at the new position
+        EdgeIndex::Slot* moved = index.find(x, list[pos].dest);
+        if (x < list[pos].dest)
+        {
+            moved->posLo = pos;
+        }
+        else
+        {
+            moved->posHi = pos;
+        }
+    }
+    list.pop_back();
+}
+
+bool Graph::removeEdge(int u, int v)
+{
     if (u < 1 || v < 1 || u > V || v > V || u == v)
     {
         return false;
     }
 
-    // Remove the edge (u, v) from the adjacency list of vertex u
-    adj[u - 1].erase(remove_if(adj[u - 1].begin(), adj[u - 1].end(), [v](const Edge &e)
-                               { return e.src == v || e.dest == v; }),
-                     adj[u - 1].end());
+    EdgeIndex::Slot* slot = index.find(u, v);
+    if (slot == nullptr)
+    {
+        return false;
+    }
 
-    // Remove the edge (v, u) from the adjacency list of vertex v
-    adj[v - 1].erase(remove_if(adj[v - 1].begin(), adj[v - 1].end(), [u](const Edge &e)
-                               { return e.src == u || e.dest == u; }),
-                     adj[v - 1].end());
+    int posLo = slot->posLo;
+    int posHi = slot->posHi;
+    index.erase(u, v);
 
-    // Get the new sizes of the adjacency lists after removal
-    size_t newSizeU = adj[u - 1].size();
-    size_t newSizeV = adj[v - 1].size();
+    // Remove the entry from the adjacency list of each endpoint
+    detach(min(u, v), posLo);
+    detach(max(u, v), posHi);
+    E--;
+    version = nextVersion();
+    return true;
+}
 
-    // Return true if either of the adjacency lists changed, indicating successful removal
-    if ((newSizeU < initialSizeU) || (newSizeV < initialSizeV))
+CSRGraph Graph::freeze() const
+{
+    CSRGraph csr;
+    csr.V = V;
+    csr.offsets.resize(V + 1, 0);
+
+    // Degree prefix sums give the start of every adjacency run
+    for (int u = 0; u < V; u++)
     {
-        E--;
-        return true;
+        csr.offsets[u + 1] = csr.offsets[u] + static_cast<int>(adj[u].size());
     }
 
-    return false;
+    csr.dest.resize(csr.offsets[V]);
+    csr.weight.resize(csr.offsets[V]);
+    for (int u = 0; u < V; u++)
+    {
+        int slot = csr.offsets[u];
+        for (const Edge& e : adj[u])
+        {
+            csr.dest[slot] = e.dest - 1;
+            csr.weight[slot] = e.weight;
+            slot++;
+        }
+    }
+    return csr;
 }
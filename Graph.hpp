@@ -6,6 +6,7 @@
 #include <queue>
 #include <algorithm>
 #include <sstream>
+#include <cstdint>
 using namespace std;
 
 /**
@@ -21,6 +22,100 @@ typedef struct Edge {
     int weight; ///< Weight of the edge
 } Edge;
 
+/**
+ * @struct CSRGraph
+ * 
+ * @brief Frozen compressed sparse row (CSR) view of a graph.
+ * 
+ * All adjacency lists are packed into two contiguous arrays, so a scan over the
+ * neighbours of a vertex is sequential. Unlike Edge, the source is implied by the
+ * position, and vertices are 0-based: the neighbours of vertex u (vertex id u + 1)
+ * are dest[offsets[u]] .. dest[offsets[u + 1] - 1], with the matching weights.
+ * The order of every adjacency list is the same as in the graph it was frozen from.
+ */
+struct CSRGraph {
+    int V = 0;              ///< Number of vertices
+    vector<int> offsets;    ///< Start of the adjacency of every vertex, V + 1 entries
+    vector<int> dest;       ///< 0-based destination of every directed edge slot
+    vector<int> weight;     ///< Weight of every directed edge slot
+
+    /**
+     * @brief Returns the number of directed edge slots (twice the number of undirected edges).
+     */
+    int slots() const { return static_cast<int>(dest.size()); }
+
+    /**
+     * @brief Returns the degree of the 0-based vertex u.
+     */
+    int degree(int u) const { return offsets[u + 1] - offsets[u]; }
+};
+
+/**
+ * @class EdgeIndex
+ * 
+ * @brief Open-addressing hash index of the undirected edges of a graph.
+ * 
+ * Every edge {u, v} is keyed by (min(u, v), max(u, v)) and maps to the positions of its
+ * two entries inside adj[min - 1] and adj[max - 1]. Lookups, inserts and erases are O(1)
+ * expected. The table uses linear probing with backward-shift deletion, so it never
+ * accumulates tombstones, and it doubles its capacity when it becomes half full.
+ */
+class EdgeIndex {
+    public:
+        /**
+         * @struct Slot
+         * @brief A table entry: the packed edge key and the positions of its two adjacency entries.
+         */
+        struct Slot {
+            uint64_t key = 0; ///< Packed (min, max) key, 0 marks an empty slot
+            int posLo = -1;   ///< Position of the edge in the adjacency list of the smaller vertex
+            int posHi = -1;   ///< Position of the edge in the adjacency list of the larger vertex
+        };
+
+    private:
+        vector<Slot> table; ///< Power-of-two sized probe table
+        size_t count = 0;   ///< Number of stored edges
+
+        static uint64_t makeKey(int u, int v);
+        size_t home(uint64_t key) const;
+        void grow();
+
+    public:
+        /**
+         * @brief Returns the slot of the edge {u, v}, or nullptr if the edge is not indexed.
+         */
+        Slot* find(int u, int v);
+        const Slot* find(int u, int v) const;
+
+        /**
+         * @brief Inserts the edge {u, v}; the edge must not be indexed yet.
+         * 
+         * @return Slot* The slot of the new edge, valid until the next insert or erase.
+         */
+        Slot* insert(int u, int v);
+
+        /**
+         * @brief Removes the edge {u, v} if it is indexed.
+         * 
+         * @return bool True if the edge was removed.
+         */
+        bool erase(int u, int v);
+
+        /**
+         * @brief Reserves room for n edges without rehashing.
+         */
+        void reserve(size_t n);
+
+        void clear() { table.clear(); count = 0; }
+
+        size_t size() const { return count; }
+
+        /**
+         * @brief Returns the number of bytes allocated by the index.
+         */
+        size_t memoryUsage() const { return table.capacity() * sizeof(Slot); }
+};
+
 /**
  * @class Graph
  * 
@@ -34,6 +129,25 @@ class Graph {
         int V; ///< Number of vertices in the graph
         int E; ///< Number of edges in the graph
         vector<vector<Edge>> adj; ///< Adjacency list representing the graph
+        EdgeIndex index; ///< Hash index of the edges, used for O(1) duplicate checks and removals
+        uint64_t version; ///< Mutation version, replaced by a fresh one on every change to the edges
+
+        /**
+         * @brief Returns a new version number, larger than every number returned before.
+         * 
+         * The counter is shared by all graphs, so two different graphs (or the same graph
+         * before and after a change) never carry the same version.
+         */
+        static uint64_t nextVersion();
+
+        /**
+         * @brief Swap-removes the entry at position pos of the adjacency list of vertex x,
+         * and updates the index entry of the edge that was moved into its place.
+         * 
+         * @param x The vertex whose adjacency list is modified
+         * @param pos The position of the entry to remove
+         */
+        void detach(int x, int pos);
     
     public:
         /**
@@ -41,7 +155,7 @@ class Graph {
          * 
          * Initializes an empty graph with 0 vertices and 0 edges.
          */
-        Graph(): V(0), E(0) {}
+        Graph(): V(0), E(0), version(nextVersion()) {}
 
         /**
          * @brief Parameterized constructor for the Graph class.
@@ -51,7 +165,7 @@ class Graph {
          * @param V Number of vertices
          * @param E Number of edges
          */
-        Graph(int V, int E): V(V), E(E) { adj.resize(V); }
+        Graph(int V, int E): V(V), E(E), version(nextVersion()) { adj.resize(V); }
 
         /**
          * @brief Virtual destructor for the Graph class.
@@ -65,16 +179,61 @@ class Graph {
          * @brief Adds an edge to the graph.
          * 
          * This function adds an edge with a given source, destination, and weight 
-         * to the graph's adjacency list.
+         * to the graph's adjacency list. Duplicates are detected through the edge index
+         * in O(1) expected time.
          * 
          * @param u Source vertex of the edge
          * @param v Destination vertex of the edge
          * @param w Weight of the edge
+         * @return bool True if the edge was added, false if it is invalid or already exists.
          */
         virtual bool addEdge(int u, int v, int w);
 
+        /**
+         * @brief Adds a batch of edges to the graph in a single pass.
+         * 
+         * Invalid edges are dropped, duplicates inside the batch are removed with one
+         * sort (the first occurrence wins, as with repeated addEdge calls), and edges that
+         * already exist in the graph are skipped. The adjacency lists and the edge index
+         * are reserved from the degree counts before anything is inserted, and the new
+         * entries are appended in the order of the batch.
+         * 
+         * @param edges The edges to add, with 1-based vertices
+         * @return int The number of edges that were added.
+         */
+        int addEdges(const vector<Edge>& edges);
+
+        /**
+         * @brief Removes the edge between u and v.
+         * 
+         * The edge is located through the edge index and swapped out of both adjacency
+         * lists, so removal is O(1) expected. The order of the remaining neighbours of
+         * u and v may change.
+         * 
+         * @param u One endpoint of the edge
+         * @param v The other endpoint of the edge
+         * @return bool True if the edge existed and was removed.
+         */
         bool removeEdge(int u, int v);
 
+        /**
+         * @brief Returns the number of bytes used by the edge index.
+         * 
+         * @return size_t The memory overhead of the index on top of the adjacency list.
+         */
+        size_t edgeIndexBytes() const { return index.memoryUsage(); }
+
+        /**
+         * @brief Returns the mutation version of the graph.
+         * 
+         * The version changes whenever addEdge, addEdges or removeEdge modifies the graph,
+         * and versions only ever increase, so a result computed at one version is still
+         * valid for as long as the graph reports that version.
+         * 
+         * @return uint64_t The current version.
+         */
+        uint64_t getVersion() const { return version; }
+
         /**
          * @brief Returns the number of vertices in the graph.
          * 
@@ -88,6 +247,15 @@ class Graph {
          * @return const vector<vector<Edge>>& The adjacency list.
          */
         const vector<vector<Edge>>& getAdj() const { return adj; }
+
+        /**
+         * @brief Builds a frozen CSR view of the graph.
+         * 
+         * The view is a snapshot: later changes to the graph are not reflected in it.
+         * 
+         * @return CSRGraph The compressed adjacency of the graph.
+         */
+        CSRGraph freeze() const;
 };
 
 #endif
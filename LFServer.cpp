@@ -53,6 +53,29 @@ void sendResponse(int clientSock, const string &response)
     }
 }
 
+/**
+ * @brief Sends a whole chunk of a streamed response to the client.
+ * 
+ * @param clientSock The client's socket descriptor.
+ * @param data The bytes to send.
+ * @param size The number of bytes to send.
+ * @return bool True if every byte was sent, false if the connection failed.
+ */
+bool sendChunk(int clientSock, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = send(clientSock, data, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
 /**
  * @brief Scans the graph input from the client.
  * 
@@ -84,12 +107,15 @@ int scanGraph(int clientSock, int &n, int &m, stringstream &ss, unique_ptr<Graph
  * @param clientSock The client's socket descriptor.
  * @param g Unique pointer to the graph object.
  * @param factory The MSTFactory object for creating MSTs.
- * @param mst Unique pointer to the MST (Tree) object.
+ * @param mst Shared pointer to the MST (Tree) object, also held by the factory cache.
  */
-void handleCommands(int clientSock, unique_ptr<Graph> &g, MSTFactory &factory, unique_ptr<Tree> &mst)
+void handleCommands(int clientSock, unique_ptr<Graph> &g, MSTFactory &factory, shared_ptr<Tree> &mst)
 {
     char buffer[1024];
     int bytesReceived;
+    MSTFormat format = MSTFormat::Indented; // Layout of the MST in the responses of this client
+    int edgeOffset = 0; // First edge of the MST page sent to this client
+    int edgeLimit = -1; // Size of the MST page sent to this client, -1 for the whole tree
 
     while (true)
     {
@@ -139,6 +165,7 @@ void handleCommands(int clientSock, unique_ptr<Graph> &g, MSTFactory &factory, u
                 mst.reset();
                 mst = nullptr;
             }
+            factory.invalidate();
             int n, m;
             int res = scanGraph(clientSock, n, m, ss, g);
             if (res == -1)
@@ -147,7 +174,9 @@ void handleCommands(int clientSock, unique_ptr<Graph> &g, MSTFactory &factory, u
                 continue;
             }
 
-            // Wait for the graph to be created
+            // Collect the edges and insert them in one batch once the upload is complete
+            vector<Edge> edges;
+            edges.reserve(m);
             for (int i = 0; i < m; i++)
             {
                 int u = 0, v = 0, w = 0;
@@ -193,11 +222,16 @@ void handleCommands(int clientSock, unique_ptr<Graph> &g, MSTFactory &factory, u
                     continue;
                 }
 
-                g->addEdge(u, v, w);
+                edges.push_back({u, v, w});
+            }
+            g->addEdges(edges);
+            {
+                unique_lock<mutex> guard(coutLock);
+                cout << "[Server] Edge index of the new graph uses " << g->edgeIndexBytes() << " bytes" << endl;
             }
             response = "Graph created with " + to_string(n) + " vertices and " + to_string(m) + " edges.\n";
         }
-        else if (cmd == "Prim" || cmd == "Kruskal")
+        else if (factory.hasStrategy(cmd))
 {
     unique_lock<mutex> guard(graphMutex, try_to_lock);
     if (!guard.owns_lock())
@@ -219,31 +253,39 @@ void handleCommands(int clientSock, unique_ptr<Graph> &g, MSTFactory &factory, u
         mst = nullptr;
     }
 
-    if (cmd == "Prim")
-    {
-        factory.setStrategy(new PrimStrategy());
-    }
-    else if (cmd == "Kruskal")
-    {
-        factory.setStrategy(new KruskalStrategy());
-    }
-
-    else
+    // Strategies are registered once in the factory and reused by name
+    if (!factory.setStrategy(cmd))
     {
         sendResponse(clientSock, "Invalid command: " + cmd + "\n");
         continue;
     }
 
     mst = factory.createMST(g);
-    response = "MST created using " + cmd + " algorithm.\n";
-    response += mst->printMST();
+    {
+        unique_lock<mutex> guard(coutLock);
+        cout << "[Server] MST cache: " << factory.cacheHits() << " hits, " << factory.cacheMisses() << " misses" << endl;
+    }
+    string header = "MST created using " + (cmd == "Auto" ? "Auto (" + factory.lastStrategy() + ")" : cmd) + " algorithm.\n";
+    // Automatically append results for MSTweight, Longestpath, and Averdist, all computed in one pass
+    // Large trees spread the diameter and the average distance over all the cores
+    shared_ptr<Tree> tree = mst;
+    TreeMetrics metrics = tree->computeMetrics(thread::hardware_concurrency());
+    // The tree does not change once created, so it is written from the local copy without holding the graph lock
+    guard.unlock();
+
+    sendResponse(clientSock, header);
+    {
+        // The tree goes out in chunks as it is written instead of being built into the response
+        ChunkWriter out([clientSock](const char *data, size_t size) { return sendChunk(clientSock, data, size); });
+        tree->writeMST(out, format, edgeOffset, edgeLimit);
+        out.write("\n");
+    }
 
-   // Automatically append results for MSTweight, Longestpath, and Averdist
-response += "TOTAL WEIGHT OF THE MST IS: " + to_string(mst->totalWeight()) + "\n";
-response += "THE LONGEST PATH (DIAMETER) OF THE MST IS: " + to_string(mst->diameter()) + '\n';
-response += "AVERAGE DISTANCE OF THE MST IS: " + to_string(mst->averageDistanceEdges()) + "\n";
+response += "TOTAL WEIGHT OF THE MST IS: " + to_string(metrics.totalWeight) + "\n";
+response += "THE LONGEST PATH (DIAMETER) OF THE MST IS: " + to_string(metrics.diameter) + '\n';
+response += "AVERAGE DISTANCE OF THE MST IS: " + to_string(metrics.averageDistance) + "\n";
 // Append the shortest path
-response += "SHORTEST PATH IS: " + mst->shortestPath() + "\n";
+response += "SHORTEST PATH IS: " + metrics.shortestPath + "\n";
 
 }
     else if (cmd == "AddEdge")
@@ -279,6 +321,8 @@ response += "SHORTEST PATH IS: " + mst->shortestPath() + "\n";
             }
             else
             {
+                // Keep the known MST up to date instead of recomputing it on the next query
+                factory.edgeAdded(u, v, w);
                 response = "Edge added between " + to_string(u) + " and " + to_string(v) + " with weight " + to_string(w) + "\n";
             }
         }
@@ -315,10 +359,99 @@ response += "SHORTEST PATH IS: " + mst->shortestPath() + "\n";
             }
             else
             {
+                // Repair the known MST instead of recomputing it on the next query
+                factory.edgeRemoved(*g, u, v);
                 response = "Edge removed between " + to_string(u) + " and " + to_string(v) + "\n";
         }   }
     }
 
+        else if (cmd == "Format")
+        {
+            string name;
+            ss >> name;
+            if (!parseMSTFormat(name, format))
+            {
+                response = "Invalid format: " + name + ". Use Indented, Flat or Binary.\n";
+            }
+            else
+            {
+                response = "MST output format set to " + name + ".\n";
+            }
+        }
+        else if (cmd == "Limit")
+        {
+            int limit = 0, offset = 0;
+            if (!(ss >> limit))
+            {
+                response = "Invalid LIMIT input. Please provide the number of edges, -1 for all, and optionally an offset.\n";
+            }
+            else
+            {
+                ss >> offset;
+                edgeLimit = limit < 0 ? -1 : limit;
+                edgeOffset = max(offset, 0);
+                response = edgeLimit < 0 && edgeOffset == 0 ? "MST output shows every edge.\n"
+                    : "MST output shows " + (edgeLimit < 0 ? string("all") : to_string(edgeLimit)) + " edges starting at edge " + to_string(edgeOffset + 1) + ".\n";
+            }
+        }
+        else if (cmd == "Path")
+        {
+            unique_lock<mutex> guard(graphMutex, try_to_lock);
+            if (!guard.owns_lock())
+            {
+                response = "Graph is being used by another thread can't search for a path.\n";
+                sendResponse(clientSock, response);
+                continue;
+            }
+
+            int u = 0, v = 0;
+            if (!(ss >> u >> v))
+            {
+                response = "Invalid PATH input. Please provide integers for u and v.\n";
+            }
+            else if (mst == nullptr)
+            {
+                response = "No MST computed yet. Run an MST command first.\n";
+            }
+            else if (mst->distance(u, v) < 0)
+            {
+                response = "No path between " + to_string(u) + " and " + to_string(v) + " in the MST.\n";
+            }
+            else
+            {
+                // Answered from the LCA index of the MST, built on the first query
+                response = "Path from " + to_string(u) + " to " + to_string(v) + ": " + mst->describePath(u, v);
+            }
+        }
+        else if (cmd == "Bottleneck")
+        {
+            unique_lock<mutex> guard(graphMutex, try_to_lock);
+            if (!guard.owns_lock())
+            {
+                response = "Graph is being used by another thread can't search for a bottleneck.\n";
+                sendResponse(clientSock, response);
+                continue;
+            }
+
+            int u = 0, v = 0;
+            optional<int> heaviest;
+            if (!(ss >> u >> v))
+            {
+                response = "Invalid BOTTLENECK input. Please provide integers for u and v.\n";
+            }
+            else if (mst == nullptr)
+            {
+                response = "No MST computed yet. Run an MST command first.\n";
+            }
+            else if (!(heaviest = mst->bottleneck(u, v)))
+            {
+                response = "No edge between " + to_string(u) + " and " + to_string(v) + " in the MST.\n";
+            }
+            else
+            {
+                response = "Bottleneck between " + to_string(u) + " and " + to_string(v) + ": heaviest edge weight " + to_string(*heaviest) + ".\n";
+            }
+        }
         else if (cmd == "Exit")
         {
             sendResponse(clientSock, "Goodbye\n");
@@ -349,10 +482,10 @@ response += "SHORTEST PATH IS: " + mst->shortestPath() + "\n";
  * @param server_sock The server's socket descriptor.
  * @param g Unique pointer to the graph object.
  * @param factory The MSTFactory object for creating MSTs.
- * @param mst Unique pointer to the MST (Tree) object.
+ * @param mst Shared pointer to the MST (Tree) object, also held by the factory cache.
  * @param pool Unique pointer to the thread pool.
  */
-void acceptConnection(int server_sock, unique_ptr<Graph> &g, MSTFactory &factory, unique_ptr<Tree> &mst, unique_ptr<LFThreadPool> &pool)
+void acceptConnection(int server_sock, unique_ptr<Graph> &g, MSTFactory &factory, shared_ptr<Tree> &mst, unique_ptr<LFThreadPool> &pool)
 {
     {
         unique_lock<mutex> guard(coutLock);
@@ -399,7 +532,7 @@ int main()
     signal(SIGINT, signalHandler);
     unique_ptr<Reactor> reactor = make_unique<Reactor>();
     unique_ptr<Graph> g;
-    unique_ptr<Tree> t;
+    shared_ptr<Tree> t;
     MSTFactory factory;
     unique_ptr<LFThreadPool> pool;
     int serverSock;
@@ -456,6 +589,12 @@ int main()
         cout << "[Server] Server socket: " << serverSock << endl;
     }
 
+    {
+        unique_lock<mutex> guard(coutLock);
+        cout << "[Server] Calibrating the MST cost model" << endl;
+    }
+    factory.calibrate();
+
     pool = make_unique<LFThreadPool>(10, *reactor);
     reactor->addHandle(serverSock, [serverSock, &g, &factory, &t, &pool]()
                        { acceptConnection(serverSock, g, factory, t, pool); });
@@ -0,0 +1,174 @@
+#include "LinkCutTree.hpp"
+
+void LinkCutTree::pull(int x)
+{
+    best[x] = x;
+    if (left[x] != -1 && value[best[left[x]]] > value[best[x]])
+    {
+        best[x] = best[left[x]];
+    }
+    if (right[x] != -1 && value[best[right[x]]] > value[best[x]])
+    {
+        best[x] = best[right[x]];
+    }
+}
+
+void LinkCutTree::push(int x)
+{
+    if (flip[x])
+    {
+        int tmp = left[x];
+        left[x] = right[x];
+        right[x] = tmp;
+        if (left[x] != -1)
+        {
+            flip[left[x]] = !flip[left[x]];
+        }
+        if (right[x] != -1)
+        {
+            flip[right[x]] = !flip[right[x]];
+        }
+        flip[x] = false;
+    }
+}
+
+void LinkCutTree::rotate(int x)
+{
+    int p = parent[x];
+    int g = parent[p];
+    bool pIsRoot = isSplayRoot(p);
+
+    if (left[p] == x)
+    {
+        left[p] = right[x];
+        if (right[x] != -1)
+        {
+            parent[right[x]] = p;
+        }
+        right[x] = p;
+    }
+    else
+    {
+        right[p] = left[x];
+        if (left[x] != -1)
+        {
+            parent[left[x]] = p;
+        }
+        left[x] = p;
+    }
+    parent[p] = x;
+    parent[x] = g;
+
+    // The path-parent pointer of a splay root is kept, but g does not get x as a child
+    if (!pIsRoot)
+    {
+        if (left[g] == p)
+        {
+            left[g] = x;
+        }
+        else
+        {
+            right[g] = x;
+        }
+    }
+    pull(p);
+    pull(x);
+}
+
+void LinkCutTree::splay(int x)
+{
+    // Push the pending reversals down from the splay root to x before rotating
+    pending.clear();
+    for (int y = x; ; y = parent[y])
+    {
+        pending.push_back(y);
+        if (isSplayRoot(y))
+        {
+            break;
+        }
+    }
+    while (!pending.empty())
+    {
+        push(pending.back());
+        pending.pop_back();
+    }
+
+    while (!isSplayRoot(x))
+    {
+        int p = parent[x];
+        if (!isSplayRoot(p))
+        {
+            int g = parent[p];
+            bool zigzig = (left[g] == p) == (left[p] == x);
+            rotate(zigzig ? p : x);
+        }
+        rotate(x);
+    }
+}
+
+void LinkCutTree::access(int x)
+{
+    int last = -1;
+    for (int y = x; y != -1; y = parent[y])
+    {
+        splay(y);
+        right[y] = last;
+        pull(y);
+        last = y;
+    }
+    splay(x);
+}
+
+void LinkCutTree::makeRoot(int x)
+{
+    access(x);
+    flip[x] = !flip[x];
+}
+
+int LinkCutTree::findRoot(int x)
+{
+    access(x);
+    while (true)
+    {
+        push(x);
+        if (left[x] == -1)
+        {
+            break;
+        }
+        x = left[x];
+    }
+    splay(x);
+    return x;
+}
+
+void LinkCutTree::link(int x, int y)
+{
+    makeRoot(x);
+    parent[x] = y;
+}
+
+void LinkCutTree::cut(int x, int y)
+{
+    makeRoot(x);
+    access(y);
+    // After access(y) with root x, x is the only node left of y on the path
+    left[y] = -1;
+    parent[x] = -1;
+    pull(y);
+}
+
+bool LinkCutTree::connected(int x, int y)
+{
+    if (x == y)
+    {
+        return true;
+    }
+    return findRoot(x) == findRoot(y);
+}
+
+int LinkCutTree::pathMax(int x, int y)
+{
+    makeRoot(x);
+    access(y);
+    return best[y];
+}
@@ -0,0 +1,70 @@
+#ifndef LINKCUTTREE_HPP
+#define LINKCUTTREE_HPP
+#include <vector>
+#include <climits>
+using namespace std;
+
+/*
+    LinkCutTree is a forest of rooted trees over the nodes [0, n) that supports link, cut,
+    connectivity and path-maximum queries in O(log n) amortized time.
+    Every node carries a value, and pathMax returns the node with the largest value on the
+    path between two nodes. Weighted edges are represented as extra nodes holding the weight,
+    linked between their two endpoints, so the path maximum is the heaviest edge of the path.
+*/
+class LinkCutTree {
+    private:
+        vector<int> left, right, parent; // Splay tree links; parent is a path-parent pointer for splay roots
+        vector<bool> flip;                // Pending reversal of the splay subtree
+        vector<int> value;                // Value of every node
+        vector<int> best;                 // Node with the largest value in the splay subtree
+        vector<int> pending;              // Reusable stack for pushing reversals down before a splay
+
+        bool isSplayRoot(int x) const { return parent[x] == -1 || (left[parent[x]] != x && right[parent[x]] != x); }
+        void pull(int x);
+        void push(int x);
+        void rotate(int x);
+        void splay(int x);
+        void access(int x);
+        void makeRoot(int x);
+        int findRoot(int x);
+
+    public:
+        LinkCutTree(int n): left(n, -1), right(n, -1), parent(n, -1), flip(n, false), value(n, INT_MIN), best(n) { for (int i = 0; i < n; i++) best[i] = i; }
+
+        /*
+        * @brief This method will set the value of the isolated node x.
+        * @param x The node.
+        * @param v The new value.
+        * @return void
+        */
+        void setValue(int x, int v) { value[x] = v; best[x] = x; }
+
+        int getValue(int x) const { return value[x]; }
+
+        /*
+        * @brief This method will add the link x - y; x and y must be in different trees.
+        * @return void
+        */
+        void link(int x, int y);
+
+        /*
+        * @brief This method will remove the link x - y; x and y must be directly linked.
+        * @return void
+        */
+        void cut(int x, int y);
+
+        /*
+        * @brief This method will check if x and y are in the same tree.
+        * @return true if there is a path between x and y.
+        */
+        bool connected(int x, int y);
+
+        /*
+        * @brief This method will find the node with the largest value on the path between x and y.
+        * x and y must be in the same tree.
+        * @return The node with the largest value on the path.
+        */
+        int pathMax(int x, int y);
+};
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef _MPSCQUEUE_HPP
+#define _MPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @class MPSCQueue
+ *
+ * A bounded lock-free queue for many producers and a single consumer.
+ *
+ * The queue is a ring of slots, each with a sequence number that tells whose turn the slot is:
+ * a producer claims the next position with one compare-and-swap on the tail and publishes its
+ * value by advancing the sequence of the slot, and the consumer takes values in order by checking
+ * that sequence, without any atomic read-modify-write of its own. Nothing is locked while the
+ * queue has work: the consumer only parks on a futex when it finds the queue empty, after
+ * announcing it in _sleeping, and a producer only makes the wake-up system call when it sees
+ * that announcement. The same handshake parks producers that find the ring full until the
+ * consumer has freed half of it, so a slow consumer is not starved by producers spinning for space.
+ *
+ * @tparam T The type of the values, which must be default constructible and movable.
+ */
+template <class T>
+class MPSCQueue
+{
+private:
+    struct Slot
+    {
+        atomic<size_t> sequence; // Position the slot expects next: pos when free, pos + 1 when holding pos
+        T value; // The value at the position, valid while the sequence is pos + 1
+    };
+
+    unique_ptr<Slot[]> _slots; // The ring
+    size_t _mask; // Capacity - 1, the capacity being a power of two
+    alignas(64) atomic<size_t> _tail; // Next position a producer claims
+    alignas(64) size_t _head; // Next position the consumer takes, only touched by the consumer
+    alignas(64) atomic<uint32_t> _sleeping; // 1 while the consumer is parked or about to park
+    alignas(64) atomic<uint32_t> _freed; // Bumped when a slot is freed while producers wait, the futex they park on
+    atomic<uint32_t> _waitingProducers; // Number of producers parked or about to park on a full ring
+    atomic<bool> _closed; // Set once no more values will be pushed
+
+    /*
+    * @brief Wakes the consumer if it announced that it is parking.
+    * The fence orders the publication of a value before the check, matching the fence the
+    * consumer puts between its announcement and its last look at the queue, so either the
+    * consumer sees the value or the producer sees the announcement.
+    */
+    void wakeConsumer()
+    {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (_sleeping.load(memory_order_relaxed) != 0 && _sleeping.exchange(0, memory_order_relaxed) != 0)
+        {
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_sleeping), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+    }
+
+public:
+    /*
+    * @brief Creates an empty queue.
+    * @param capacity The number of slots, rounded up to a power of two.
+    */
+    explicit MPSCQueue(size_t capacity = 4096) : _tail(0), _head(0), _sleeping(0), _freed(0), _waitingProducers(0), _closed(false)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        _mask = size - 1;
+        _slots.reset(new Slot[size]);
+        for (size_t i = 0; i < size; i++)
+        {
+            _slots[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    /*
+    * @brief Appends a value if there is a free slot. Safe to call from any number of threads.
+    * @param value The value, moved from only on success.
+    * @return bool False if the queue is full.
+    */
+    bool tryPush(T& value)
+    {
+        size_t pos = _tail.load(memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = _slots[pos & _mask];
+            intptr_t diff = static_cast<intptr_t>(slot.sequence.load(memory_order_acquire)) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (_tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                {
+                    slot.value = move(value);
+                    slot.sequence.store(pos + 1, memory_order_release);
+                    wakeConsumer();
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                // The consumer has not taken the value a full ring ago yet
+                return false;
+            }
+            else
+            {
+                pos = _tail.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    /*
+    * @brief Appends a value, parking while the queue is full. Safe to call from any number of threads.
+    * @param value The value to append.
+    */
+    void push(T value)
+    {
+        while (!tryPush(value))
+        {
+            uint32_t freed = _freed.load(memory_order_acquire);
+            _waitingProducers.fetch_add(1, memory_order_seq_cst);
+            if (tryPush(value))
+            {
+                _waitingProducers.fetch_sub(1, memory_order_relaxed);
+                return;
+            }
+            // Returns at once if a slot was freed since freed was read
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_freed), FUTEX_WAIT_PRIVATE, freed, nullptr, nullptr, 0);
+            _waitingProducers.fetch_sub(1, memory_order_relaxed);
+        }
+    }
+
+    /*
+    * @brief Takes the oldest value if there is one. Only the consumer thread may call this.
+    * @param value Receives the value.
+    * @return bool False if the queue is empty.
+    */
+    bool tryPop(T& value)
+    {
+        Slot& slot = _slots[_head & _mask];
+        if (slot.sequence.load(memory_order_acquire) != _head + 1)
+        {
+            return false;
+        }
+        value = move(slot.value);
+        // Release whatever the moved-from value still holds before the slot is reused
+        slot.value = T();
+        slot.sequence.store(_head + _mask + 1, memory_order_release);
+        _head++;
+        // Pairs with the increment of _waitingProducers, so a producer either sees the free slot or gets woken.
+        // Parked producers are woken once the ring is half empty rather than for every slot, which
+        // would make them park again right away. A ring producers park on is always drained that far.
+        atomic_thread_fence(memory_order_seq_cst);
+        if (_waitingProducers.load(memory_order_relaxed) != 0 && _tail.load(memory_order_relaxed) - _head <= (_mask + 1) / 2)
+        {
+            _freed.fetch_add(1, memory_order_release);
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_freed), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+        }
+        return true;
+    }
+
+    /*
+    * @brief Takes the oldest value, parking while the queue is empty. Only the consumer thread may call this.
+    * @param value Receives the value.
+    * @return bool False once the queue is closed and every value has been taken.
+    */
+    bool pop(T& value)
+    {
+        while (true)
+        {
+            if (tryPop(value))
+            {
+                return true;
+            }
+            if (_closed.load(memory_order_acquire))
+            {
+                // Values pushed before close are still taken
+                return tryPop(value);
+            }
+            _sleeping.store(1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (tryPop(value))
+            {
+                _sleeping.store(0, memory_order_relaxed);
+                return true;
+            }
+            if (!_closed.load(memory_order_acquire))
+            {
+                // Returns at once if a producer cleared the flag in the meantime
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_sleeping), FUTEX_WAIT_PRIVATE, 1, nullptr, nullptr, 0);
+            }
+            _sleeping.store(0, memory_order_relaxed);
+        }
+    }
+
+    /*
+    * @brief Marks the queue as finished and wakes the consumer, whose pop then drains it and returns false.
+    */
+    void close()
+    {
+        _closed.store(true, memory_order_release);
+        wakeConsumer();
+    }
+};
+
+#endif
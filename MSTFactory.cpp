@@ -1,16 +1,251 @@
 #include "MSTFactory.hpp"
+#include <chrono>
+#include <cmath>
+#include <random>
+
+GraphStats GraphStats::of(const CSRGraph& g)
+{
+    GraphStats stats;
+    stats.V = g.V;
+    stats.E = g.slots() / 2;
+    if (g.weight.empty())
+    {
+        return stats;
+    }
+
+    // Radix keys flip the sign bit; the passes that matter are the bytes where the smallest and largest key differ
+    auto range = minmax_element(g.weight.begin(), g.weight.end());
+    uint32_t diff = (static_cast<uint32_t>(*range.first) ^ 0x80000000u) ^ (static_cast<uint32_t>(*range.second) ^ 0x80000000u);
+    while (diff != 0)
+    {
+        stats.weightBytes++;
+        diff >>= 8;
+    }
+    return stats;
+}
+
+MSTFactory::MSTFactory(): _cores(max(1u, thread::hardware_concurrency()))
+{
+    _strategies["Prim"] = make_unique<PrimHeapStrategy>();
+    _strategies["DensePrim"] = make_unique<PrimStrategy>();
+    _strategies["Kruskal"] = make_unique<KruskalStrategy>();
+    _strategies["ParallelKruskal"] = make_unique<ParallelKruskalStrategy>(_cores);
+    _strategies["Boruvka"] = make_unique<BoruvkaStrategy>(_cores);
+    _strategies["FilterKruskal"] = make_unique<FilterKruskalStrategy>();
+    for (const auto& entry : _strategies)
+    {
+        _costScale[entry.first] = 1.0;
+    }
+}
 
 void MSTFactory::setStrategy(MSTStrategy* strategy)
 {
-    if (this->_strategy != nullptr)
+    this->_custom = unique_ptr<MSTStrategy>(strategy);
+    this->_strategy = strategy;
+    this->_selected.clear();
+    this->_auto = false;
+    // Trees of the previous custom strategy were cached under the same empty name
+    this->_cache.erase("");
+    // A known MST it produced would be handed out as one of the new strategy
+    if (this->_mstStrategy.empty())
+    {
+        forgetMST();
+    }
+}
+
+bool MSTFactory::setStrategy(const string& name)
+{
+    if (name == "Auto")
+    {
+        _auto = true;
+        return true;
+    }
+    auto it = _strategies.find(name);
+    if (it == _strategies.end())
+    {
+        return false;
+    }
+    _strategy = it->second.get();
+    _selected = name;
+    _auto = false;
+    return true;
+}
+
+bool MSTFactory::hasStrategy(const string& name) const
+{
+    return name == "Auto" || _strategies.count(name) > 0;
+}
+
+double MSTFactory::modelledWork(const string& name, const GraphStats& stats) const
+{
+    double V = stats.V, E = static_cast<double>(stats.E);
+    double logV = log2(V + 2);
+    // The parallel strategies stay on one thread below PARALLEL_THRESHOLD edges
+    double threads = static_cast<size_t>(stats.E) < PARALLEL_THRESHOLD ? 1 : _cores;
+
+    if (name == "Prim")
     {
-        this->_strategy.reset();
+        return (V + E) * logV;
     }
-    this->_strategy = unique_ptr<MSTStrategy>(strategy);
+    if (name == "DensePrim")
+    {
+        return V * V + E;
+    }
+    if (name == "Kruskal")
+    {
+        return E * log2(E + 2) + V;
+    }
+    if (name == "ParallelKruskal")
+    {
+        return E * (1 + stats.weightBytes) / threads + V;
+    }
+    if (name == "Boruvka")
+    {
+        return (E + V) * logV / threads;
+    }
+    if (name == "FilterKruskal")
+    {
+        return E + V * logV * log2(E / (V + 1) + 2);
+    }
+    return E * log2(E + 2) + V;
 }
 
-unique_ptr<Tree> MSTFactory::createMST(unique_ptr<Graph>& g)
+string MSTFactory::chooseStrategy(const CSRGraph& g) const
 {
-    vector<Edge> edges = _strategy->findMST(*g);
-    return make_unique<Tree>(edges);
-}
\ No newline at end of file
+    GraphStats stats = GraphStats::of(g);
+    string best;
+    double bestCost = 0;
+    for (const auto& entry : _costScale)
+    {
+        double cost = entry.second * modelledWork(entry.first, stats);
+        if (best.empty() || cost < bestCost)
+        {
+            best = entry.first;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+void MSTFactory::calibrate()
+{
+    // A sparse graph and a dense graph with about half of all possible edges, small enough for unoptimised builds
+    mt19937 rng(4050);
+    vector<CSRGraph> samples;
+    for (auto [n, m] : {make_pair(2000, 10000), make_pair(150, 5500)})
+    {
+        Graph g(n, m);
+        vector<Edge> edges;
+        edges.reserve(m + n);
+        for (int v = 2; v <= n; v++)
+        {
+            // A random spanning tree keeps the sample connected
+            edges.push_back({v, static_cast<int>(1 + rng() % (v - 1)), static_cast<int>(rng() % 1000000)});
+        }
+        while (static_cast<int>(edges.size()) < m)
+        {
+            edges.push_back({static_cast<int>(1 + rng() % n), static_cast<int>(1 + rng() % n), static_cast<int>(rng() % 1000000)});
+        }
+        g.addEdges(edges);
+        samples.push_back(g.freeze());
+    }
+
+    for (auto& entry : _strategies)
+    {
+        double scale = 0;
+        for (const CSRGraph& sample : samples)
+        {
+            auto start = chrono::steady_clock::now();
+            entry.second->findMST(sample);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            scale += seconds / modelledWork(entry.first, GraphStats::of(sample));
+        }
+        _costScale[entry.first] = scale / samples.size();
+    }
+}
+
+shared_ptr<Tree> MSTFactory::createMST(unique_ptr<Graph>& g)
+{
+    // Versions are never reused, so every cached tree of an older version is stale
+    if (g->getVersion() != _cacheVersion)
+    {
+        _cache.clear();
+        _cacheVersion = g->getVersion();
+    }
+    const string key = _auto ? "Auto" : _selected;
+    auto cached = _cache.find(key);
+    if (cached != _cache.end())
+    {
+        _cacheHits++;
+        _lastStrategy = cached->second.strategy;
+        return cached->second.tree;
+    }
+    _cacheMisses++;
+
+    shared_ptr<Tree> tree;
+    // The known MST is only handed out for the strategy that produced it, or for Auto
+    if (_hasMST && _mstVertices == g->getVerticesNumber() && (_auto || _selected == _mstStrategy))
+    {
+        // The MST is already known, possibly updated by edge insertions since it was computed
+        _lastStrategy = _mstStrategy;
+        tree = make_shared<Tree>(_mstVertices, _dynamic != nullptr ? _dynamic->edges() : _mstEdges);
+    }
+    else
+    {
+        // The trees cached for this version stay valid, only the known MST is replaced
+        forgetMST();
+        CSRGraph csr = g->freeze();
+        if (_auto)
+        {
+            _selected = chooseStrategy(csr);
+            _strategy = _strategies[_selected].get();
+        }
+        _lastStrategy = _selected;
+        _mstStrategy = _selected;
+        _mstEdges = _strategy->findMST(csr);
+        _mstVertices = g->getVerticesNumber();
+        _hasMST = true;
+        tree = make_shared<Tree>(_mstVertices, _mstEdges);
+    }
+    _cache[key] = {tree, _lastStrategy};
+    return tree;
+}
+
+DynamicMST& MSTFactory::dynamicMST()
+{
+    if (_dynamic == nullptr)
+    {
+        _dynamic = make_unique<DynamicMST>(_mstVertices, _mstEdges);
+        _mstEdges.clear();
+    }
+    return *_dynamic;
+}
+
+void MSTFactory::edgeAdded(int u, int v, int w)
+{
+    if (_hasMST)
+    {
+        dynamicMST().insertEdge(u, v, w);
+    }
+}
+
+void MSTFactory::edgeRemoved(const Graph& g, int u, int v)
+{
+    if (_hasMST)
+    {
+        dynamicMST().removeEdge(g, u, v);
+    }
+}
+
+void MSTFactory::forgetMST()
+{
+    _hasMST = false;
+    _mstEdges.clear();
+    _dynamic.reset();
+}
+
+void MSTFactory::invalidate()
+{
+    _cache.clear();
+    forgetMST();
+}
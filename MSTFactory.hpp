@@ -1,14 +1,84 @@
 #ifndef MSTFACTORY_HPP
 #define MSTFACTORY_HPP
 #include <memory>
+#include <map>
+#include <string>
 #include "MSTStrategy.hpp"
+#include "DynamicMST.hpp"
+
+/*
+    GraphStats holds the graph statistics the Auto mode of MSTFactory bases its choice on.
+*/
+struct GraphStats {
+    int V = 0;             // Number of vertices
+    long long E = 0;       // Number of undirected edges
+    int weightBytes = 0;   // Number of radix digits (bytes) that vary between the smallest and largest weight
+
+    /*
+    * @brief This method will compute the statistics of the frozen graph g in one pass over its weights.
+    * @param g The CSR view of the graph.
+    * @return GraphStats The statistics of g.
+    */
+    static GraphStats of(const CSRGraph& g);
+};
 
 class MSTFactory
 {
     private:
-        unique_ptr<MSTStrategy> _strategy;
+        map<string, unique_ptr<MSTStrategy>> _strategies; // Every registered strategy, created once and reused by name
+        map<string, double> _costScale; // Calibrated seconds per unit of modelled work of every strategy
+        MSTStrategy* _strategy = nullptr; // Selected strategy, owned by _strategies or by _custom
+        unique_ptr<MSTStrategy> _custom; // Strategy handed over through setStrategy(MSTStrategy*)
+        string _selected; // Name of the selected strategy, empty for a custom one
+        bool _auto = false; // True if the strategy is chosen per graph by the cost model
+        string _lastStrategy; // Name of the strategy that produced the last MST
+        unsigned _cores; // Number of hardware threads the parallel strategies can use
+        vector<Edge> _mstEdges; // Edges of the last MST, valid while _hasMST is true
+        int _mstVertices = 0; // Number of vertices of the graph of the last MST
+        string _mstStrategy; // Name of the strategy that produced the last MST, empty for a custom one
+        bool _hasMST = false; // True if the last MST still matches the graph
+        unique_ptr<DynamicMST> _dynamic; // Maintained MST, built on the first edge update after an MST query
+
+        /*
+            CachedMST is a finished MST together with the strategy that produced it.
+        */
+        struct CachedMST {
+            shared_ptr<Tree> tree; // The tree, which also remembers its metrics once computed
+            string strategy; // Name of the strategy that produced the tree
+        };
+        map<string, CachedMST> _cache; // MSTs of the graph version _cacheVersion, keyed by the requested strategy
+        uint64_t _cacheVersion = 0; // Graph version the cached MSTs belong to
+        size_t _cacheHits = 0; // Number of createMST calls answered from the cache
+        size_t _cacheMisses = 0; // Number of createMST calls that had to build a tree
+
+        /*
+        * @brief This method will return the maintained MST, building it from the last MST edges on first use.
+        * @return DynamicMST& The maintained MST.
+        */
+        DynamicMST& dynamicMST();
+
+        /*
+        * @brief This method will forget the known MST, keeping the cached trees.
+        * @return void
+        */
+        void forgetMST();
+
+        /*
+        * @brief This method will estimate the amount of work a strategy does on a graph, in abstract units.
+        * The calibrated cost scale of the strategy converts it into seconds.
+        * @param name The name of the strategy.
+        * @param stats The statistics of the graph.
+        * @return double The modelled work.
+        */
+        double modelledWork(const string& name, const GraphStats& stats) const;
         
     public:
+        /*
+        * @brief Registers one instance of every strategy under the name of its server command:
+        * Prim, DensePrim, Kruskal, ParallelKruskal, Boruvka and FilterKruskal.
+        */
+        MSTFactory();
+
         /*
         * @brief This method will set the strategy that will be used to find the minimum spanning tree.
         * @param strategy The strategy that will be used to find the minimum spanning tree.
@@ -16,13 +86,104 @@ class MSTFactory
         */
         void setStrategy(MSTStrategy* strategy);
 
+        /*
+        * @brief This method will select one of the registered strategies, without allocating a new one.
+        * The name "Auto" lets the cost model pick a strategy for every graph instead.
+        * @param name The name of the strategy, or "Auto".
+        * @return true if the name is known, false otherwise.
+        */
+        bool setStrategy(const string& name);
+
+        /*
+        * @brief This method will check if name is a registered strategy or "Auto".
+        * @param name The name to check.
+        * @return true if setStrategy(name) would succeed.
+        */
+        bool hasStrategy(const string& name) const;
+
+        /*
+        * @brief This method will pick the registered strategy with the lowest predicted time on the graph g.
+        * The prediction is the modelled work of the strategy times its calibrated cost scale.
+        * @param g The CSR view of the graph.
+        * @return string The name of the chosen strategy.
+        */
+        string chooseStrategy(const CSRGraph& g) const;
+
+        /*
+        * @brief This method will time every registered strategy on a small sparse graph and a small dense graph,
+        * and set the cost scale of each strategy from the ratio of measured time to modelled work.
+        * It is meant to be called once at startup; without it all the cost scales are 1.
+        * @return void
+        */
+        void calibrate();
+
+        /*
+        * @brief This method will take over the cost scales of another factory, so a factory created after
+        * startup chooses like the calibrated one without timing the strategies again.
+        * @param calibrated The factory calibrate was called on.
+        * @return void
+        */
+        void adoptCalibration(const MSTFactory& calibrated) { _costScale = calibrated._costScale; }
+
         /*
         * @brief This method will create the minimum spanning tree of the graph g using the strategy set.
+        * Trees are cached by (graph version, requested strategy): asking again for the same strategy before the
+        * graph changes returns the same tree, with the metrics it already computed. On a cache miss, if the MST
+        * of g is already known (computed earlier and kept up to date through edgeAdded and edgeRemoved) and was
+        * produced by the set strategy or Auto is set, it is returned without running the strategy again.
+        * Any other strategy runs and its tree becomes the known MST.
         * @param g The graph that will be used to find the minimum spanning tree.
-        * @return Tree* The minimum spanning tree of the graph g.
+        * @return shared_ptr<Tree> The minimum spanning tree of the graph g, shared with the cache.
         */
-        unique_ptr<Tree> createMST(unique_ptr<Graph>& g);
-        void destroyStrategy(){_strategy.reset();}
+        shared_ptr<Tree> createMST(unique_ptr<Graph>& g);
+
+        /*
+        * @brief This method will return the name of the strategy that produced the last MST.
+        * @return const string& The name of the strategy, empty if it was set through setStrategy(MSTStrategy*).
+        */
+        const string& lastStrategy() const { return _lastStrategy; }
+
+        /*
+        * @brief This method will return the number of createMST calls answered from the cache.
+        * @return size_t The number of cache hits.
+        */
+        size_t cacheHits() const { return _cacheHits; }
+
+        /*
+        * @brief This method will return the number of createMST calls that had to build a new tree.
+        * @return size_t The number of cache misses.
+        */
+        size_t cacheMisses() const { return _cacheMisses; }
+
+        /*
+        * @brief This method will update the known MST after the edge (u, v, w) was added to the graph.
+        * The update takes O(log V); nothing happens if no MST was computed for the graph yet.
+        * @param u The first vertex of the new edge.
+        * @param v The second vertex of the new edge.
+        * @param w The weight of the new edge.
+        * @return void
+        */
+        void edgeAdded(int u, int v, int w);
+
+        /*
+        * @brief This method will repair the known MST after the edge u - v was removed from the graph g.
+        * Removing a non-tree edge leaves the MST as it is; removing a tree edge searches only the cut
+        * between the two resulting subtrees for a replacement. Nothing happens if no MST is known.
+        * @param g The graph, which must no longer contain the edge u - v.
+        * @param u The first vertex of the removed edge.
+        * @param v The second vertex of the removed edge.
+        * @return void
+        */
+        void edgeRemoved(const Graph& g, int u, int v);
+
+        /*
+        * @brief This method will forget the known MST and the cached trees, so the next createMST runs the strategy.
+        * It must be called whenever the graph is replaced.
+        * @return void
+        */
+        void invalidate();
+
+        void destroyStrategy(){_strategy = nullptr; _custom.reset(); _strategies.clear(); _cache.clear();}
 };
 
-#endif
\ No newline at end of file
+#endif
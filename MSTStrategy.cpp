@@ -1,6 +1,8 @@
 #include "MSTStrategy.hpp"
+#include <atomic>
+#include <memory>
 
-int PrimStrategy::minKey(vector<int> key, vector<bool> mstSet, int V)
+int PrimStrategy::minKey(const vector<int>& key, const vector<bool>& mstSet, int V)
 {
     int min = INT_MAX, min_index = -1;
     for (int v = 0; v < V; v++)
@@ -14,9 +16,9 @@ int PrimStrategy::minKey(vector<int> key, vector<bool> mstSet, int V)
     return min_index;
 }
 
-vector<Edge> PrimStrategy::findMST(const Graph& g)
+vector<Edge> PrimStrategy::findMST(const CSRGraph& g)
 {
-    int V = g.getVerticesNumber();
+    int V = g.V;
     vector<Edge> result;
     // Array to store the constructed MST
     vector<int> parent(V, -1);
@@ -25,26 +27,27 @@ vector<Edge> PrimStrategy::findMST(const Graph& g)
     // To represent set of vertices not yet included in MST
     vector<bool> mstSet(V, false);
 
-    // Always include first 1st vertex in MST.
-    key[0] = 0;
-    // First node is always root of MST
-    parent[0] = -1;
-
-    // The MST will have V vertices
-    for (int count = 0; count < V - 1; count++)
+    // Every vertex joins the MST set once. When no vertex left is reachable from the trees built
+    // so far, the first of them starts a new tree, so a disconnected graph gives a spanning forest
+    for (int count = 0; count < V; count++)
     {
         // Pick the minimum key vertex from the set of vertices not yet included in MST
         int u = minKey(key, mstSet, V);
+        if (u == -1)
+        {
+            u = static_cast<int>(find(mstSet.begin(), mstSet.end(), false) - mstSet.begin());
+            key[u] = 0;
+        }
 
         // Add the picked vertex to the MST Set
         mstSet[u] = true;
 
         // Update key value and parent index of the adjacent vertices of the picked vertex.
         // Consider only those vertices which are not yet included in MST
-        for (const Edge& e : g.getAdj()[u])
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++)
         {
-            int v = e.dest - 1;
-            int weight = e.weight;
+            int v = g.dest[i];
+            int weight = g.weight[i];
             if (mstSet[v] == false && weight < key[v])
             {
                 parent[v] = u;
@@ -53,82 +56,507 @@ vector<Edge> PrimStrategy::findMST(const Graph& g)
         }
     }
 
-    for (int i = 1; i < V; i++)
+    // The roots of the trees have no parent and no edge
+    for (int i = 0; i < V; i++)
     {
-        result.push_back({parent[i] + 1, i + 1, key[i]});
+        if (parent[i] != -1)
+        {
+            result.push_back({parent[i] + 1, i + 1, key[i]});
+        }
     }
 
     return result;
 }
 
-int DSU::find(int i)
+void IndexedMinHeap::siftUp(int i)
 {
-    if (parent[i] == -1)
+    int v = heap[i];
+    while (i > 0)
     {
-        return i;
+        int p = (i - 1) / 2;
+        if (key[heap[p]] <= key[v])
+        {
+            break;
+        }
+        heap[i] = heap[p];
+        pos[heap[i]] = i;
+        i = p;
     }
-    return find(parent[i]);
+    heap[i] = v;
+    pos[v] = i;
 }
 
-void DSU::unite(int x, int y)
+void IndexedMinHeap::siftDown(int i)
 {
-    int s1 = find(x);
-    int s2 = find(y);
-
-    if (s1 != s2)
+    int v = heap[i];
+    while (true)
     {
-        if (rank[s1] < rank[s2])
+        int c = 2 * i + 1;
+        if (c >= size)
         {
-            parent[s1] = s2;
+            break;
         }
-        else if (rank[s1] > rank[s2])
+        if (c + 1 < size && key[heap[c + 1]] < key[heap[c]])
         {
-            parent[s2] = s1;
+            c++;
         }
-        else
+        if (key[heap[c]] >= key[v])
         {
-            parent[s2] = s1;
-            rank[s1]++;
+            break;
         }
+        heap[i] = heap[c];
+        pos[heap[i]] = i;
+        i = c;
     }
+    heap[i] = v;
+    pos[v] = i;
 }
 
+void IndexedMinHeap::pushOrDecrease(int v, int k)
+{
+    if (pos[v] == -1)
+    {
+        key[v] = k;
+        heap[size] = v;
+        pos[v] = size;
+        siftUp(size++);
+    }
+    else if (k < key[v])
+    {
+        key[v] = k;
+        siftUp(pos[v]);
+    }
+}
+
+int IndexedMinHeap::popMin()
+{
+    int v = heap[0];
+    pos[v] = -1;
+    if (--size > 0)
+    {
+        heap[0] = heap[size];
+        siftDown(0);
+    }
+    return v;
+}
 
-vector<Edge> KruskalStrategy::findMST(const Graph& g) {
-    int V = g.getVerticesNumber();
+vector<Edge> PrimHeapStrategy::findMST(const CSRGraph& g)
+{
+    int V = g.V;
+    vector<Edge> result;
+    result.reserve(V > 0 ? V - 1 : 0);
+    // parent[v] is the MST neighbour through which v was reached
+    vector<int> parent(V, -1);
+    // To represent set of vertices already included in MST
+    vector<bool> mstSet(V, false);
+    IndexedMinHeap pq(V);
+
+    // Every unvisited vertex starts a new tree, so disconnected graphs produce a spanning forest
+    for (int root = 0; root < V; root++)
+    {
+        if (mstSet[root])
+        {
+            continue;
+        }
+        pq.pushOrDecrease(root, 0);
+
+        while (!pq.empty())
+        {
+            int u = pq.popMin();
+            mstSet[u] = true;
+            if (parent[u] != -1)
+            {
+                result.push_back({parent[u] + 1, u + 1, pq.keyOf(u)});
+            }
+
+            // Relax every edge leaving u towards the vertices that are not yet in the MST
+            for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++)
+            {
+                int v = g.dest[i];
+                if (!mstSet[v] && (!pq.contains(v) || g.weight[i] < pq.keyOf(v)))
+                {
+                    parent[v] = u;
+                    pq.pushOrDecrease(v, g.weight[i]);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+vector<Edge> KruskalStrategy::findMST(const CSRGraph& g) {
+    int V = g.V;
     vector<Edge> result;
     int e = 0; // Number of edges in the MST
     size_t i = 0; // Index used for sorted edges
 
     // Get all edges from the graph
     vector<Edge> edges;
+    edges.reserve(g.slots() / 2);
     for (int u = 0; u < V; u++) {
-        for (const Edge& edge : g.getAdj()[u]) {
-            if (u < edge.dest) { // Ensure each edge is added only once
-                edges.push_back(edge);
+        for (int j = g.offsets[u]; j < g.offsets[u + 1]; j++) {
+            if (u < g.dest[j]) { // Ensure each edge is added only once
+                edges.push_back({u + 1, g.dest[j] + 1, g.weight[j]});
             }
         }
     }
 
     // Sort all the edges in non-decreasing order of their weight
-    sort(edges.begin(), edges.end(), [](Edge a, Edge b) {
+    sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
         return a.weight < b.weight;
     });
 
-    DSU dsu(V);
+    UnionFind dsu(V);
 
     // Iterate through sorted edges and apply union-find
     while (e < V - 1 && i < edges.size()) {
-        Edge next_edge = edges[i++];
+        const Edge& next_edge = edges[i++];
 
         int x = dsu.find(next_edge.src - 1);
         int y = dsu.find(next_edge.dest - 1);
 
         if (x != y) {
             result.push_back(next_edge);
-            dsu.unite(x, y);
+            dsu.uniteRoots(x, y);
             e++;
         }
     }
     return result;
-}
\ No newline at end of file
+}
+
+/*
+* @brief Runs fn(t) for every t in [0, threads), each on its own thread, and waits for all of them.
+*/
+template <class F>
+static void parallelFor(unsigned threads, F fn)
+{
+    vector<thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; t++)
+    {
+        workers.emplace_back(fn, t);
+    }
+    fn(0);
+    for (thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/*
+* @brief Gathers every undirected edge of g once, in parallel over vertex ranges.
+* @param g The graph whose edges are collected.
+* @param threads The number of threads to use.
+* @return vector<Edge> The edges of the graph, in the same order as a sequential scan.
+*/
+static vector<Edge> collectEdges(const CSRGraph& g, unsigned threads)
+{
+    int V = g.V;
+    // Split the vertices into ranges holding about the same number of edge slots
+    vector<int> bounds(threads + 1, V);
+    bounds[0] = 0;
+    for (unsigned t = 1; t < threads; t++)
+    {
+        long long target = static_cast<long long>(g.slots()) * t / threads;
+        bounds[t] = static_cast<int>(lower_bound(g.offsets.begin(), g.offsets.end() - 1, target) - g.offsets.begin());
+    }
+
+    // First pass counts the edges owned by every range, so the second pass can write in place
+    vector<size_t> start(threads + 1, 0);
+    parallelFor(threads, [&](unsigned t) {
+        size_t count = 0;
+        for (int u = bounds[t]; u < bounds[t + 1]; u++) {
+            for (int j = g.offsets[u]; j < g.offsets[u + 1]; j++) {
+                count += u < g.dest[j];
+            }
+        }
+        start[t + 1] = count;
+    });
+    for (unsigned t = 0; t < threads; t++)
+    {
+        start[t + 1] += start[t];
+    }
+
+    vector<Edge> edges(start[threads]);
+    parallelFor(threads, [&](unsigned t) {
+        size_t k = start[t];
+        for (int u = bounds[t]; u < bounds[t + 1]; u++) {
+            for (int j = g.offsets[u]; j < g.offsets[u + 1]; j++) {
+                if (u < g.dest[j]) { // Ensure each edge is added only once
+                    edges[k++] = {u + 1, g.dest[j] + 1, g.weight[j]};
+                }
+            }
+        }
+    });
+    return edges;
+}
+
+void ParallelKruskalStrategy::radixSort(vector<Edge>& edges, unsigned threads)
+{
+    const size_t n = edges.size();
+    const int RADIX = 256;
+    vector<Edge> buffer(n);
+    // Every thread owns the same contiguous chunk of the array in every pass
+    vector<size_t> chunk(threads + 1);
+    for (unsigned t = 0; t <= threads; t++)
+    {
+        chunk[t] = n * t / threads;
+    }
+    vector<size_t> offsets(static_cast<size_t>(threads) * RADIX);
+
+    // Flipping the sign bit makes the unsigned order of the keys match the signed order of the weights
+    auto digit = [](const Edge& e, int shift) {
+        return ((static_cast<uint32_t>(e.weight) ^ 0x80000000u) >> shift) & 0xFF;
+    };
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        // Per-thread histograms of the current digit
+        fill(offsets.begin(), offsets.end(), 0);
+        parallelFor(threads, [&](unsigned t) {
+            size_t* hist = &offsets[static_cast<size_t>(t) * RADIX];
+            for (size_t i = chunk[t]; i < chunk[t + 1]; i++) {
+                hist[digit(edges[i], shift)]++;
+            }
+        });
+
+        // Skip the pass if every key has the same digit
+        bool trivial = false;
+        for (int d = 0; d < RADIX && !trivial; d++)
+        {
+            size_t total = 0;
+            for (unsigned t = 0; t < threads; t++)
+            {
+                total += offsets[static_cast<size_t>(t) * RADIX + d];
+            }
+            trivial = total == n;
+        }
+        if (trivial)
+        {
+            continue;
+        }
+
+        // Exclusive prefix sum in (digit, thread) order keeps the sort stable
+        size_t sum = 0;
+        for (int d = 0; d < RADIX; d++)
+        {
+            for (unsigned t = 0; t < threads; t++)
+            {
+                size_t count = offsets[static_cast<size_t>(t) * RADIX + d];
+                offsets[static_cast<size_t>(t) * RADIX + d] = sum;
+                sum += count;
+            }
+        }
+
+        parallelFor(threads, [&](unsigned t) {
+            size_t* next = &offsets[static_cast<size_t>(t) * RADIX];
+            for (size_t i = chunk[t]; i < chunk[t + 1]; i++) {
+                buffer[next[digit(edges[i], shift)]++] = edges[i];
+            }
+        });
+        edges.swap(buffer);
+    }
+}
+
+vector<Edge> ParallelKruskalStrategy::findMST(const CSRGraph& g)
+{
+    int V = g.V;
+    unsigned threads = static_cast<size_t>(g.slots() / 2) < PARALLEL_THRESHOLD ? 1 : _threads;
+    vector<Edge> result;
+    result.reserve(V > 0 ? V - 1 : 0);
+
+    vector<Edge> edges = collectEdges(g, threads);
+    radixSort(edges, threads);
+
+    UnionFind dsu(V);
+
+    // Iterate through sorted edges and apply union-find
+    for (size_t i = 0; i < edges.size() && static_cast<int>(result.size()) < V - 1; i++)
+    {
+        int x = dsu.find(edges[i].src - 1);
+        int y = dsu.find(edges[i].dest - 1);
+
+        if (x != y)
+        {
+            result.push_back(edges[i]);
+            dsu.uniteRoots(x, y);
+        }
+    }
+    return result;
+}
+
+/*
+* @brief Lowers slot to key if key is smaller, without taking a lock.
+*/
+static void atomicMin(atomic<uint64_t>& slot, uint64_t key)
+{
+    uint64_t current = slot.load(memory_order_relaxed);
+    while (key < current && !slot.compare_exchange_weak(current, key, memory_order_relaxed))
+    {
+    }
+}
+
+vector<Edge> BoruvkaStrategy::findMST(const CSRGraph& g)
+{
+    const uint64_t NONE = UINT64_MAX;
+    int V = g.V;
+    unsigned threads = static_cast<size_t>(g.slots() / 2) < PARALLEL_THRESHOLD ? 1 : _threads;
+    vector<Edge> result;
+    result.reserve(V > 0 ? V - 1 : 0);
+
+    // Edges that still join two different components, compacted after every round
+    vector<Edge> edges = collectEdges(g, threads);
+    vector<Edge> next(edges.size());
+    // comp[v] is the representative of the component of v during the current round
+    vector<int> comp(V);
+    unique_ptr<atomic<uint64_t>[]> best(new atomic<uint64_t>[V]);
+    UnionFind components(V);
+    for (int v = 0; v < V; v++)
+    {
+        comp[v] = v;
+    }
+
+    auto vertexRange = [V, threads](unsigned t) { return make_pair(static_cast<int>(static_cast<long long>(V) * t / threads), static_cast<int>(static_cast<long long>(V) * (t + 1) / threads)); };
+    vector<size_t> kept(threads + 1);
+
+    while (!edges.empty())
+    {
+        size_t n = edges.size();
+        auto edgeRange = [n, threads](unsigned t) { return make_pair(n * t / threads, n * (t + 1) / threads); };
+
+        // Every component looks for its lightest outgoing edge; the key orders edges by (weight, position)
+        parallelFor(threads, [&](unsigned t) {
+            auto [from, to] = vertexRange(t);
+            for (int v = from; v < to; v++) {
+                best[v].store(NONE, memory_order_relaxed);
+            }
+        });
+        parallelFor(threads, [&](unsigned t) {
+            auto [from, to] = edgeRange(t);
+            for (size_t i = from; i < to; i++) {
+                uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(edges[i].weight) ^ 0x80000000u) << 32) | i;
+                atomicMin(best[comp[edges[i].src - 1]], key);
+                atomicMin(best[comp[edges[i].dest - 1]], key);
+            }
+        });
+
+        // Add the picked edges; an edge picked by both of its components is added once
+        bool merged = false;
+        for (int c = 0; c < V; c++)
+        {
+            uint64_t key = best[c].load(memory_order_relaxed);
+            if (key == NONE)
+            {
+                continue;
+            }
+            const Edge& e = edges[key & 0xFFFFFFFFu];
+            if (components.unite(e.src - 1, e.dest - 1))
+            {
+                result.push_back(e);
+                merged = true;
+            }
+        }
+        if (!merged)
+        {
+            break;
+        }
+
+        // Contract: relabel the vertices, then drop the edges that became internal to a component
+        parallelFor(threads, [&](unsigned t) {
+            auto [from, to] = vertexRange(t);
+            for (int v = from; v < to; v++) {
+                comp[v] = components.root(v);
+            }
+        });
+        parallelFor(threads, [&](unsigned t) {
+            auto [from, to] = edgeRange(t);
+            size_t count = 0;
+            for (size_t i = from; i < to; i++) {
+                count += comp[edges[i].src - 1] != comp[edges[i].dest - 1];
+            }
+            kept[t + 1] = count;
+        });
+        for (unsigned t = 0; t < threads; t++)
+        {
+            kept[t + 1] += kept[t];
+        }
+        parallelFor(threads, [&](unsigned t) {
+            auto [from, to] = edgeRange(t);
+            size_t k = kept[t];
+            for (size_t i = from; i < to; i++) {
+                if (comp[edges[i].src - 1] != comp[edges[i].dest - 1]) {
+                    next[k++] = edges[i];
+                }
+            }
+        });
+        next.resize(kept[threads]);
+        edges.swap(next);
+        next.resize(edges.size());
+    }
+    return result;
+}
+
+// Ranges with at most this many edges are sorted directly instead of being partitioned further
+static const ptrdiff_t FILTER_KRUSKAL_BASE = 1 << 10;
+
+void FilterKruskalStrategy::filterKruskal(vector<Edge>::iterator first, vector<Edge>::iterator last, UnionFind& components, vector<Edge>& result, int V)
+{
+    if (first == last || static_cast<int>(result.size()) >= V - 1)
+    {
+        return;
+    }
+
+    vector<Edge>::iterator mid = last;
+    if (last - first > FILTER_KRUSKAL_BASE)
+    {
+        // Median of three spread out samples as the pivot weight
+        int a = first->weight, b = (first + (last - first) / 2)->weight, c = (last - 1)->weight;
+        int pivot = max(min(a, b), min(max(a, b), c));
+        mid = partition(first, last, [pivot](const Edge& e) { return e.weight < pivot; });
+        if (mid == first)
+        {
+            // The pivot is the smallest weight, put the edges equal to it on the light side
+            mid = partition(first, last, [pivot](const Edge& e) { return e.weight <= pivot; });
+        }
+    }
+
+    if (mid == last)
+    {
+        // Base case: a small range, or a range where every weight is the same
+        sort(first, last, [](const Edge& a, const Edge& b) {
+            return a.weight < b.weight;
+        });
+        for (vector<Edge>::iterator it = first; it != last && static_cast<int>(result.size()) < V - 1; ++it)
+        {
+            int x = components.find(it->src - 1);
+            int y = components.find(it->dest - 1);
+            if (x != y)
+            {
+                result.push_back(*it);
+                components.uniteRoots(x, y);
+            }
+        }
+        return;
+    }
+
+    filterKruskal(first, mid, components, result, V);
+
+    // Drop the heavy edges that the light half already connected
+    vector<Edge>::iterator heavyEnd = partition(mid, last, [&components](const Edge& e) {
+        return components.find(e.src - 1) != components.find(e.dest - 1);
+    });
+    filterKruskal(mid, heavyEnd, components, result, V);
+}
+
+vector<Edge> FilterKruskalStrategy::findMST(const CSRGraph& g)
+{
+    int V = g.V;
+    vector<Edge> result;
+    result.reserve(V > 0 ? V - 1 : 0);
+
+    vector<Edge> edges = collectEdges(g, 1);
+    UnionFind components(V);
+    filterKruskal(edges.begin(), edges.end(), components, result, V);
+    return result;
+}
@@ -1,7 +1,12 @@
 #ifndef MSTSTRATEGY_HPP
 #define MSTSTRATEGY_HPP
 #include <iostream>
+#include <thread>
 #include "Tree.hpp"
+#include "UnionFind.hpp"
+
+// Inputs below this many edges are handled by a single thread, where spawning threads costs more than it saves
+const size_t PARALLEL_THRESHOLD = 1 << 16;
 
 /*
     MSTStrategy is an abstract class that defines the interface for the strategy pattern.
@@ -10,13 +15,23 @@
 */
 class MSTStrategy {
     public:
+        virtual ~MSTStrategy() = default;
+
         /*
-        * @brief This method will find the minimum spanning tree of the graph g.
+        * @brief This method will find the minimum spanning tree of the frozen graph g.
         * It is a pure virtual method, so it must be implemented by the concrete classes.
+        * @param g The CSR view of the graph that will be used to find the minimum spanning tree.
+        * @return vector<Edge> The edges that form the minimum spanning tree, with 1-based vertices.
+        */
+        vector<Edge> virtual findMST(const CSRGraph& g) = 0;
+
+        /*
+        * @brief This method will find the minimum spanning tree of the graph g.
+        * The graph is frozen into its CSR view and passed to the CSR overload.
         * @param g The graph that will be used to find the minimum spanning tree.
         * @return vector<Edge> The edges that form the minimum spanning tree.
         */
-        vector<Edge> virtual findMST(const Graph& g) = 0;
+        vector<Edge> virtual findMST(const Graph& g) { return findMST(g.freeze()); }
 };
 
 /*
@@ -33,42 +48,72 @@ class PrimStrategy: public MSTStrategy {
         * @param V The number of vertices in the graph.
         * @return The index of the vertex with the minimum key value.
         */
-        int minKey(vector<int> key, vector<bool> mstSet, int V);
+        int minKey(const vector<int>& key, const vector<bool>& mstSet, int V);
 
     public:
+        using MSTStrategy::findMST;
+
         /*
         * @brief This method will find the minimum spanning tree of the graph g using Prim's algorithm.
+        * A disconnected graph gives a minimum spanning forest, one tree per component.
         * @param g The graph that will be used to find the minimum spanning tree.
         * @ return vector<Edge> The edges that form the minimum spanning tree.
         */
-        vector<Edge> findMST(const Graph& g) override;
+        vector<Edge> findMST(const CSRGraph& g) override;
 };
 
 /*
-    DSU is a class that implements the Disjoint Set Union data structure.
-    It is used in the Kruskal's algorithm to find the minimum spanning tree.
+    IndexedMinHeap is a binary min-heap over the vertex ids [0, n) that supports decrease-key.
+    Every vertex has a fixed slot in the position array, so the heap never allocates after construction.
 */
-class DSU {
+class IndexedMinHeap {
     private:
-        vector<int> parent;
-        vector<int> rank;
+        vector<int> heap; // heap[i] is the vertex stored at heap slot i
+        vector<int> pos;  // pos[v] is the heap slot of vertex v, or -1 if v is not in the heap
+        vector<int> key;  // key[v] is the priority of vertex v
+        int size;
+
+        void siftUp(int i);
+        void siftDown(int i);
+
     public:
-        DSU(int n): parent(n, -1), rank(n, 0) {}
-        
+        IndexedMinHeap(int n): heap(n), pos(n, -1), key(n, INT_MAX), size(0) {}
+
+        bool empty() const { return size == 0; }
+        bool contains(int v) const { return pos[v] != -1; }
+        int keyOf(int v) const { return key[v]; }
+
         /*
-        * @brief This method will find the representative of the set that contains the element u.
-        * @param u The element whose representative will be found.
-        * @return The representative of the set that contains the element u.
+        * @brief This method will insert the vertex v with priority k, or lower its priority to k if v is already in the heap.
+        * Nothing happens if v is already in the heap with a priority lower or equal to k.
+        * @param v The vertex.
+        * @param k The new priority of the vertex.
+        * @return void
         */
-        int find(int u);
+        void pushOrDecrease(int v, int k);
 
         /*
-        * @brief This method will unite the sets that contain the elements u and v.
-        * @param u The first element.
-        * @param v The second element.
-        * @return void
+        * @brief This method will remove and return the vertex with the minimum priority.
+        * @return The vertex with the minimum priority.
+        */
+        int popMin();
+};
+
+/*
+    PrimHeapStrategy is a concrete class that inherits from MSTStrategy.
+    It implements the Prim's algorithm with an indexed priority queue, which runs in O(E log V)
+    instead of the O(V^2) linear scan of PrimStrategy. Disconnected graphs yield a spanning forest.
+*/
+class PrimHeapStrategy: public MSTStrategy {
+    public:
+        using MSTStrategy::findMST;
+
+        /*
+        * @brief This method will find the minimum spanning tree of the graph g using Prim's algorithm.
+        * @param g The graph that will be used to find the minimum spanning tree.
+        * @ return vector<Edge> The edges that form the minimum spanning tree.
         */
-        void unite(int u, int v);
+        vector<Edge> findMST(const CSRGraph& g) override;
 };
 
 /*
@@ -77,12 +122,101 @@ class DSU {
 */
 class KruskalStrategy: public MSTStrategy {
     public:
+        using MSTStrategy::findMST;
+
         /*
         * @brief This method will find the minimum spanning tree of the graph g using Kruskal's algorithm.
         * @param g The graph that will be used to find the minimum spanning tree.
         * @ return vector<Edge> The edges that form the minimum spanning tree.
         */
-        vector<Edge> findMST(const Graph& g) override;
+        vector<Edge> findMST(const CSRGraph& g) override;
+};
+
+/*
+    ParallelKruskalStrategy is a concrete class that inherits from MSTStrategy.
+    It implements the Kruskal's algorithm with the edge collection and the sort spread over several threads:
+    every thread gathers the edges of a contiguous vertex range, and the edges are ordered with a
+    multi-threaded LSD radix sort on the integer weights instead of a comparison sort.
+*/
+class ParallelKruskalStrategy: public MSTStrategy {
+    private:
+        unsigned _threads; // Number of worker threads used by the collection and the sort
+
+        /*
+        * @brief This method will sort the edges by weight with a parallel LSD radix sort (8 bits per pass).
+        * Passes where every key has the same digit are skipped, so small weight ranges need fewer passes.
+        * @param edges The edges to sort.
+        * @param threads The number of threads to use.
+        * @return void
+        */
+        static void radixSort(vector<Edge>& edges, unsigned threads);
+
+    public:
+        ParallelKruskalStrategy(unsigned threads = thread::hardware_concurrency()): _threads(threads > 0 ? threads : 1) {}
+
+        using MSTStrategy::findMST;
+
+        /*
+        * @brief This method will find the minimum spanning tree of the graph g using the parallel Kruskal's algorithm.
+        * @param g The graph that will be used to find the minimum spanning tree.
+        * @ return vector<Edge> The edges that form the minimum spanning tree.
+        */
+        vector<Edge> findMST(const CSRGraph& g) override;
+};
+
+/*
+    BoruvkaStrategy is a concrete class that inherits from MSTStrategy.
+    It implements the Boruvka's algorithm: every round, each component picks its lightest outgoing edge,
+    all the picked edges are added to the tree and the components they join are contracted.
+    The search for the lightest edges and the contraction run on several threads, and there are at most
+    log V rounds. Ties are broken by edge position, so the picked edges never close a cycle.
+*/
+class BoruvkaStrategy: public MSTStrategy {
+    private:
+        unsigned _threads; // Number of worker threads used by every round
+
+    public:
+        BoruvkaStrategy(unsigned threads = thread::hardware_concurrency()): _threads(threads > 0 ? threads : 1) {}
+
+        using MSTStrategy::findMST;
+
+        /*
+        * @brief This method will find the minimum spanning tree of the graph g using Boruvka's algorithm.
+        * @param g The graph that will be used to find the minimum spanning tree.
+        * @ return vector<Edge> The edges that form the minimum spanning tree.
+        */
+        vector<Edge> findMST(const CSRGraph& g) override;
+};
+
+/*
+    FilterKruskalStrategy is a concrete class that inherits from MSTStrategy.
+    It implements the Filter-Kruskal algorithm: the edges are partitioned around a pivot weight as in quicksort,
+    the light half is solved first, and the heavy half is then filtered, dropping every edge whose endpoints are
+    already in the same component before it is ever sorted. On dense graphs most heavy edges are filtered out,
+    so most of the O(E log E) sorting work of KruskalStrategy is avoided.
+*/
+class FilterKruskalStrategy: public MSTStrategy {
+    private:
+        /*
+        * @brief This method will add to result the MST edges found among the edges in [first, last).
+        * @param first The first edge of the range.
+        * @param last One past the last edge of the range.
+        * @param components The union-find structure of the components built so far.
+        * @param result The edges that form the minimum spanning tree.
+        * @param V The number of vertices in the graph.
+        * @return void
+        */
+        void filterKruskal(vector<Edge>::iterator first, vector<Edge>::iterator last, UnionFind& components, vector<Edge>& result, int V);
+
+    public:
+        using MSTStrategy::findMST;
+
+        /*
+        * @brief This method will find the minimum spanning tree of the graph g using the Filter-Kruskal algorithm.
+        * @param g The graph that will be used to find the minimum spanning tree.
+        * @ return vector<Edge> The edges that form the minimum spanning tree.
+        */
+        vector<Edge> findMST(const CSRGraph& g) override;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,381 @@
+#include "ParallelMetrics.hpp"
+#include <algorithm>
+#include <thread>
+
+/**
+ * @brief Runs fn(t) for every t in [0, threads), each on its own thread, and waits for all of them.
+ */
+template <class F>
+static void parallelFor(unsigned threads, F fn)
+{
+    vector<thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; t++)
+    {
+        workers.emplace_back(fn, t);
+    }
+    fn(0);
+    for (thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+SequentialTreeMetrics::SequentialTreeMetrics(const vector<int>& parentAt, const vector<int>& weightAt)
+{
+    int n = static_cast<int>(parentAt.size());
+
+    // Every component is a contiguous range of the layout that starts at its root
+    vector<int> componentStart;
+    for (int k = 0; k < n; k++)
+    {
+        if (parentAt[k] == -1)
+        {
+            componentStart.push_back(k);
+        }
+    }
+
+    // One reverse scan per component finishes every subtree before its parent uses it:
+    // size gives the pairs every edge lies on, down the longest path hanging below every position
+    vector<long long> size(n, 1);
+    vector<long long> down(n, 0);
+    for (size_t c = 0; c < componentStart.size(); c++)
+    {
+        int begin = componentStart[c];
+        int end = c + 1 < componentStart.size() ? componentStart[c + 1] : n;
+        long long members = end - begin;
+        for (int k = end - 1; k > begin; k--)
+        {
+            int p = parentAt[k];
+            long long w = weightAt[k];
+            // The pair sum grows like V^3 on a path, past 64 bits at V = 10^7
+            pairSum += static_cast<__int128>(w) * (size[k] * (members - size[k]));
+            size[p] += size[k];
+            // The longest path through p joins the chain through k with the best chain found below p so far
+            if (begin == 0)
+            {
+                longest = max(longest, down[p] + down[k] + w);
+            }
+            down[p] = max(down[p], down[k] + w);
+        }
+        pairs += members * (members - 1) / 2;
+    }
+}
+
+unsigned ParallelTreeMetrics::blocksFor(size_t n, unsigned threads)
+{
+    // The blocks together do up to twice the work of one reverse scan, so two threads gain nothing
+    if (threads < 3)
+    {
+        return 1;
+    }
+    return static_cast<unsigned>(max<size_t>(1, min<size_t>(threads, n / MIN_BLOCK)));
+}
+
+ParallelTreeMetrics::ParallelTreeMetrics(const vector<int>& parentAt, const vector<int>& weightAt, unsigned blockCount)
+    : parentAt(parentAt), weightAt(weightAt)
+{
+    int n = static_cast<int>(parentAt.size());
+    if (n == 0)
+    {
+        return;
+    }
+    blockCount = max(1u, blockCount);
+    blockSize = static_cast<int>((static_cast<long long>(n) + blockCount - 1) / blockCount);
+    for (int begin = 0; begin < n; begin += blockSize)
+    {
+        Block block;
+        block.begin = begin;
+        block.end = min(n, begin + blockSize);
+        blocks.push_back(block);
+    }
+    unsigned threads = static_cast<unsigned>(blocks.size());
+    size.resize(n);
+    depth.resize(n);
+    deepest.resize(n);
+
+    parallelFor(threads, [&](unsigned t) { scanBlock(blocks[t]); });
+    linkBlocks();
+    parallelFor(threads, [&](unsigned t) {
+        for (Group& group : blocks[t].exits)
+        {
+            group.targetDepth = chainDepth(group.target);
+        }
+    });
+    // Everything later blocks hang below the chain of a block, except their own tops, which are still open
+    parallelFor(threads, [&](unsigned t) {
+        Block& block = blocks[t];
+        forAttached(t, [&block](const Group& group) {
+            block.attachedSize += group.size;
+            if (group.size > 0)
+            {
+                block.attachedDeepest = max(block.attachedDeepest, group.targetDepth + group.deepest);
+            }
+        });
+    });
+
+    // The top of a block depends only on the blocks after it, so one backward pass closes all of them
+    for (size_t i = blocks.size(); i-- > 0;)
+    {
+        Block& block = blocks[i];
+        if (block.top == -1 || parentAt[block.top] == -1)
+        {
+            continue;
+        }
+        Group top{parentAt[block.top]};
+        top.size = size[block.top] + block.attachedSize;
+        top.deepest = block.topDeepest;
+        if (block.attachedDeepest != LLONG_MIN)
+        {
+            top.deepest = max(top.deepest, block.attachedDeepest - block.anchor);
+        }
+        top.targetDepth = block.anchor;
+        Block& parent = blocks[top.target / blockSize];
+        parent.attachedSize += top.size;
+        parent.attachedDeepest = max(parent.attachedDeepest, top.targetDepth + top.deepest);
+        parent.pending.push_back(top);
+    }
+
+    parallelFor(threads, [&](unsigned t) { finishChain(blocks[t]); });
+    parallelFor(threads, [&](unsigned t) { finishBlock(blocks[t]); });
+    vector<__int128> blockPairSum(threads, 0);
+    vector<long long> blockPairs(threads, 0);
+    parallelFor(threads, [&](unsigned t) { sumBlock(blocks[t], blockPairSum[t], blockPairs[t]); });
+    for (unsigned t = 0; t < threads; t++)
+    {
+        if (blocks[t].begin < secondRoot)
+        {
+            longest = max(longest, blocks[t].longest);
+        }
+        pairSum += blockPairSum[t];
+        pairs += blockPairs[t];
+    }
+    vector<long long>().swap(deepest);
+}
+
+template <class F>
+void ParallelTreeMetrics::forAttached(size_t i, F fn) const
+{
+    int begin = blocks[i].begin;
+    int end = blocks[i].end;
+    for (size_t j = i + 1; j < blocks.size(); j++)
+    {
+        // The exits of a block are ordered by decreasing parent, so the ones into block i are a range
+        const vector<Group>& exits = blocks[j].exits;
+        auto it = partition_point(exits.begin(), exits.end(), [end](const Group& group) { return group.target >= end; });
+        for (; it != exits.end() && it->target >= begin; ++it)
+        {
+            fn(*it);
+        }
+    }
+}
+
+void ParallelTreeMetrics::scanBlock(Block& block)
+{
+    int begin = block.begin;
+    int end = block.end;
+
+    // Depths relative to the parent of every subtree that enters the block from an earlier position.
+    // Once a subtree of an earlier position is left it is never entered again, so the parents of
+    // the entries only decrease and equal parents are consecutive.
+    block.cut = end;
+    for (int k = begin; k < end; k++)
+    {
+        int p = parentAt[k];
+        size[k] = 1;
+        if (p == -1)
+        {
+            depth[k] = 0;
+            block.lastRoot = k;
+            if (k > 0 && block.cut == end)
+            {
+                block.cut = k;
+            }
+        }
+        else if (p < begin)
+        {
+            depth[k] = weightAt[k];
+            if (block.exits.empty() || block.exits.back().target != p)
+            {
+                block.exits.push_back(Group{p});
+            }
+        }
+        else
+        {
+            depth[k] = depth[p] + weightAt[k];
+        }
+        deepest[k] = depth[k];
+    }
+
+    // The ancestors of the next block that lie in this one are a chain, the only positions whose
+    // subtrees continue past the block. Their deepest values leave out the next chain position,
+    // which finishChain adds once it is complete.
+    vector<int> chain;
+    if (end < static_cast<int>(parentAt.size()))
+    {
+        for (int q = parentAt[end]; q >= begin; q = parentAt[q])
+        {
+            chain.push_back(q);
+            block.top = q;
+        }
+    }
+
+    // The offsets of the depths cancel within a subtree entering the block, so the longest path through
+    // every position joins its two deepest children exactly as in the sequential scan
+    size_t next = 0;
+    size_t g = block.exits.size();
+    for (int k = end - 1; k >= begin; k--)
+    {
+        bool onChain = next < chain.size() && chain[next] == k;
+        next += onChain;
+        int p = parentAt[k];
+        if (p >= begin)
+        {
+            size[p] += size[k];
+            if (!onChain)
+            {
+                if (p < block.cut)
+                {
+                    block.longest = max(block.longest, deepest[p] + deepest[k] - 2 * depth[p]);
+                }
+                deepest[p] = max(deepest[p], deepest[k]);
+            }
+        }
+        else if (p != -1 && k != block.top)
+        {
+            while (block.exits[g - 1].target != p)
+            {
+                g--;
+            }
+            Group& group = block.exits[g - 1];
+            group.size += size[k];
+            group.second = max(group.second, min(group.deepest, deepest[k]));
+            group.deepest = max(group.deepest, deepest[k]);
+        }
+    }
+    for (int q : chain)
+    {
+        block.topDeepest = max(block.topDeepest, deepest[q]);
+    }
+}
+
+void ParallelTreeMetrics::linkBlocks()
+{
+    // The parent of a top is an ancestor of the start of its block, so it lies on the chain of an
+    // earlier block, whose anchor is already known
+    int rootBefore = -1;
+    secondRoot = static_cast<int>(parentAt.size());
+    for (Block& block : blocks)
+    {
+        block.rootBefore = rootBefore;
+        if (block.lastRoot != -1)
+        {
+            rootBefore = block.lastRoot;
+        }
+        if (block.cut < block.end)
+        {
+            secondRoot = min(secondRoot, block.cut);
+        }
+        if (block.top != -1 && parentAt[block.top] != -1)
+        {
+            block.anchor = chainDepth(parentAt[block.top]);
+        }
+    }
+}
+
+void ParallelTreeMetrics::finishChain(Block& block)
+{
+    if (block.top == -1)
+    {
+        return;
+    }
+    vector<Group> attached = block.pending;
+    forAttached(&block - blocks.data(), [&attached](const Group& group) {
+        if (group.size > 0)
+        {
+            attached.push_back(group);
+        }
+    });
+    sort(attached.begin(), attached.end(), [](const Group& a, const Group& b) { return a.target > b.target; });
+
+    // Walking the chain upwards, every position gains what hangs below the deeper chain and the
+    // children of later blocks, which complete its two deepest children
+    long long addSize = 0;
+    long long below = LLONG_MIN;
+    size_t g = 0;
+    for (int q = parentAt[block.end]; q >= block.begin; q = parentAt[q])
+    {
+        long long current = deepest[q];
+        auto join = [&](long long child) {
+            if (q < secondRoot)
+            {
+                block.longest = max(block.longest, current + child - 2 * depth[q]);
+            }
+            current = max(current, child);
+        };
+        if (below != LLONG_MIN)
+        {
+            join(below);
+        }
+        for (; g < attached.size() && attached[g].target == q; g++)
+        {
+            const Group& group = attached[g];
+            long long offset = group.targetDepth - block.anchor;
+            addSize += group.size;
+            if (group.second != LLONG_MIN && q < secondRoot)
+            {
+                block.longest = max(block.longest, group.deepest + group.second + 2 * offset - 2 * depth[q]);
+            }
+            join(group.deepest + offset);
+        }
+        size[q] += static_cast<int>(addSize);
+        deepest[q] = current;
+        below = current;
+    }
+}
+
+void ParallelTreeMetrics::finishBlock(Block& block)
+{
+    // Every subtree entering the block is a contiguous range, so the offset changes only at its entry
+    long long offset = 0;
+    size_t g = 0;
+    for (int k = block.begin; k < block.end; k++)
+    {
+        int p = parentAt[k];
+        if (p == -1)
+        {
+            offset = 0;
+        }
+        else if (p < block.begin)
+        {
+            while (block.exits[g].target != p)
+            {
+                g++;
+            }
+            offset = block.exits[g].targetDepth;
+        }
+        depth[k] += offset;
+        deepest[k] += offset;
+    }
+}
+
+void ParallelTreeMetrics::sumBlock(const Block& block, __int128& blockPairSum, long long& blockPairs) const
+{
+    int root = block.rootBefore;
+    for (int k = block.begin; k < block.end; k++)
+    {
+        int p = parentAt[k];
+        if (p == -1)
+        {
+            root = k;
+            long long members = size[k];
+            blockPairs += members * (members - 1) / 2;
+        }
+        else
+        {
+            long long members = size[root];
+            long long below = size[k];
+            blockPairSum += static_cast<__int128>(weightAt[k]) * (below * (members - below));
+        }
+    }
+}
@@ -0,0 +1,172 @@
+#ifndef PARALLELMETRICS_HPP
+#define PARALLELMETRICS_HPP
+
+#include <climits>
+#include <vector>
+using namespace std;
+
+/**
+ * @class SequentialTreeMetrics
+ *
+ * @brief Computes the diameter and the pair distance sum of a rooted layout with one reverse scan.
+ *
+ * The input is the layout Tree keeps, as for ParallelTreeMetrics. In the layout every parent comes
+ * before its children, so one reverse scan per component finishes every subtree before its parent
+ * uses it. This is what Tree uses below the size where more threads pay off, and the reference
+ * ParallelTreeMetrics is checked against.
+ */
+class SequentialTreeMetrics {
+    private:
+        long long longest = 0; ///< Diameter of the component at position 0
+        __int128 pairSum = 0; ///< Sum of the distances of all pairs in the same component
+        long long pairs = 0; ///< Number of pairs in the same component
+
+    public:
+        /**
+         * @brief Computes all the results.
+         *
+         * @param parentAt Position of the parent of every position, -1 for the root of a component.
+         * @param weightAt Weight of the edge to the parent of every position.
+         */
+        SequentialTreeMetrics(const vector<int>& parentAt, const vector<int>& weightAt);
+
+        /**
+         * @brief Returns the diameter of the component at position 0.
+         */
+        long long diameter() const { return longest; }
+
+        /**
+         * @brief Returns the sum of the distances of all pairs of positions in the same component.
+         */
+        __int128 pairDistanceSum() const { return pairSum; }
+
+        /**
+         * @brief Returns the number of pairs of positions in the same component.
+         */
+        long long pairCount() const { return pairs; }
+};
+
+/**
+ * @class ParallelTreeMetrics
+ *
+ * @brief Computes the subtree sizes, weighted depths, diameter and pair distance sum of a rooted
+ * layout on several threads.
+ *
+ * The input is the layout Tree keeps: positions in DFS preorder, one component after the other,
+ * with the position of the parent and the weight of the edge to it. The layout is cut into one
+ * contiguous block per thread and every block is first reduced on its own, as if the parents
+ * before it did not exist. What a block cannot finish is small: the subtrees hanging below earlier
+ * positions, grouped by their parent, and the chain of its ancestors of the next block, the only
+ * positions whose subtrees reach past it. A sequential pass over these summaries (O(blocks) work)
+ * resolves the chain tops from the last block to the first, and three more parallel scans fix up
+ * the chains, turn the block-relative depths into weighted depths and sum the pair distances.
+ * Every result is exact, so the metrics match those of SequentialTreeMetrics bit for bit.
+ */
+class ParallelTreeMetrics {
+    private:
+        /**
+         * @brief Consecutive positions of a block whose parent is the same position of an earlier block.
+         */
+        struct Group {
+            int target; ///< Position of the common parent
+            long long size = 0; ///< Total size of the subtrees of the group
+            long long deepest = LLONG_MIN; ///< Deepest weighted depth in those subtrees, relative to target
+            long long second = LLONG_MIN; ///< Deepest weighted depth in the subtrees of the other children, relative to target
+            long long targetDepth = 0; ///< Weighted depth of target
+        };
+
+        /**
+         * @brief What a block knows after its local scan, and what the passes after it add.
+         */
+        struct Block {
+            int begin = 0; ///< First position of the block
+            int end = 0; ///< Position after the last one of the block
+            int top = -1; ///< Topmost ancestor of end inside the block, -1 if there is none
+            int lastRoot = -1; ///< Last component root in the block, -1 if there is none
+            int cut = 0; ///< First component root after position 0 in the block, end if there is none
+            int rootBefore = -1; ///< Last component root before the block
+            long long anchor = 0; ///< Weighted depth of the parent of top, which the depths along its chain are relative to
+            long long topDeepest = LLONG_MIN; ///< Deepest weighted depth below top within the block, relative to anchor
+            long long longest = 0; ///< Longest path found through the positions of the block before cut
+            vector<Group> exits; ///< Subtrees hanging below earlier positions, in layout order
+            vector<Group> pending; ///< Tops of later blocks whose parent lies on this block's chain
+            long long attachedSize = 0; ///< Total size hanging below this block's chain from later blocks
+            long long attachedDeepest = LLONG_MIN; ///< Deepest weighted depth hanging below the chain from later blocks
+        };
+
+        const vector<int>& parentAt; ///< Position of the parent of every position, -1 for a root
+        const vector<int>& weightAt; ///< Weight of the edge to the parent of every position
+        int blockSize = 1; ///< Number of positions per block, the last block may be shorter
+        int secondRoot = 0; ///< Position of the second component root, where the component at position 0 ends
+        vector<Block> blocks; ///< The blocks, one per thread
+        vector<int> size; ///< Subtree size of every position
+        vector<long long> depth; ///< Weighted depth of every position
+        vector<long long> deepest; ///< Deepest weighted depth in the subtree of every position, released at the end
+        long long longest = 0; ///< Diameter of the component at position 0
+        __int128 pairSum = 0; ///< Sum of the distances of all pairs in the same component
+        long long pairs = 0; ///< Number of pairs in the same component
+
+        /**
+         * @brief Returns the weighted depth of a position on the chain of its block, once the anchors are known.
+         */
+        long long chainDepth(int k) const { return blocks[k / blockSize].anchor + depth[k]; }
+
+        /**
+         * @brief Calls fn on every group of a later block whose parent lies in block i.
+         */
+        template <class F>
+        void forAttached(size_t i, F fn) const;
+
+        void scanBlock(Block& block);
+        void linkBlocks();
+        void finishChain(Block& block);
+        void finishBlock(Block& block);
+        void sumBlock(const Block& block, __int128& blockPairSum, long long& blockPairs) const;
+
+    public:
+        // Blocks shorter than this cost more in thread start-up than they save
+        static const int MIN_BLOCK = 1 << 16;
+
+        /**
+         * @brief Returns the number of blocks worth using for a layout of n positions with the given threads.
+         *
+         * @return unsigned At most threads, and 1 if the layout is too small or there are too few threads to gain from more.
+         */
+        static unsigned blocksFor(size_t n, unsigned threads);
+
+        /**
+         * @brief Computes all the results, with one thread per block.
+         *
+         * @param parentAt Position of the parent of every position, -1 for the root of a component.
+         * @param weightAt Weight of the edge to the parent of every position.
+         * @param blocks Number of blocks, each scanned by its own thread.
+         */
+        ParallelTreeMetrics(const vector<int>& parentAt, const vector<int>& weightAt, unsigned blocks);
+
+        /**
+         * @brief Returns the number of positions in the subtree of every position.
+         */
+        const vector<int>& subtreeSizes() const { return size; }
+
+        /**
+         * @brief Returns the total weight of the path from the root of the component to every position.
+         */
+        const vector<long long>& weightedDepths() const { return depth; }
+
+        /**
+         * @brief Returns the diameter of the component at position 0.
+         */
+        long long diameter() const { return longest; }
+
+        /**
+         * @brief Returns the sum of the distances of all pairs of positions in the same component.
+         */
+        __int128 pairDistanceSum() const { return pairSum; }
+
+        /**
+         * @brief Returns the number of pairs of positions in the same component.
+         */
+        long long pairCount() const { return pairs; }
+};
+
+#endif
@@ -10,6 +10,8 @@
 #include "Tree.hpp"
 #include "MSTFactory.hpp"
 #include "ActiveObject.hpp"
+#include "StageGraph.hpp"
+#include "ParallelMetrics.hpp"
 
 // Constants
 const int port = 4050; ///< Server port number
@@ -17,27 +19,49 @@ const int port = 4050; ///< Server port number
 // Global variables
 function<void(int)> signalHandlerLambda; ///< Lambda function for handling signals
 atomic<int> clientNumber(0); ///< Tracks the number of connected clients
-mutex graphLock; ///< Mutex for synchronizing access to the graph
+mutex sessionsLock; ///< Mutex for synchronizing access to the named sessions
 mutex futureLock; ///< Mutex for synchronizing access to shared futures
 mutex &coutLock = ActiveObject::getOutputMutex(); ///< Mutex for synchronizing console output
 
 atomic<bool> terminateFlag(false); ///< Flag to signal the termination of the server
 
+/**
+ * @struct Session
+ * 
+ * @brief Holds the graph of a client session together with its MST and MST factory.
+ * 
+ * Every connection starts in a session of its own, and the clients that join the same named
+ * session share its graph. The tasks of a session only lock the mutex of that session, so the
+ * pipeline stages run tasks of different sessions without waiting for each other. The graph
+ * updates of a session on stage 0 are enqueued with its id as the key, so a stage 0 with
+ * several workers still applies them in order; the other stages answer a client that waits
+ * for them, and any free worker takes their tasks.
+ */
+struct Session
+{
+    size_t id; ///< Number of the session, the key that keeps its graph updates in order on stage 0
+    mutex graphLock; ///< Mutex for synchronizing access to the graph, the MST and the factory
+    unique_ptr<Graph> g; ///< The graph of the session
+    MSTFactory factory; ///< The MST factory of the session, with its own strategy and cache
+    shared_ptr<Tree> mst; ///< The last MST (Tree) of the session, also held by the factory cache
+};
+
+map<string, shared_ptr<Session>> namedSessions; ///< Sessions joined by name, shared by their clients
+atomic<size_t> sessionCount(0); ///< Number of sessions created, the source of their ids
+
 /**
  * @struct functArgs
  * 
  * @brief Holds arguments for thread functions handling client commands.
  * 
- * This struct contains references to the client's socket, the pipeline of ActiveObjects,
- * the graph, the MST factory, and the resulting MST.
+ * This struct contains the client's socket and references to the pipeline of ActiveObjects
+ * and to the calibrated MST factory the sessions of the client copy their cost model from.
  */
 struct functArgs
 {
     int clientSock; ///< The client's socket descriptor
     vector<unique_ptr<ActiveObject>> &pipeline; ///< Pipeline of ActiveObjects for task execution
-    unique_ptr<Graph> &g; ///< Reference to the graph object
-    MSTFactory &factory; ///< Reference to the MST factory
-    unique_ptr<Tree> &mst; ///< Reference to the MST (Tree) object
+    const MSTFactory &calibrated; ///< Reference to the calibrated MST factory
 };
 
 /**
@@ -54,7 +78,7 @@ void signalHandler(int signum)
     cout << "Interrupt signal (" << signum << ") received.\n";
     coutLock.unlock();
     terminateFlag.store(true);
-    unique_lock<mutex> guard(graphLock);
+    unique_lock<mutex> guard(sessionsLock);
     signalHandlerLambda(signum);
     guard.unlock();
     exit(signum);
@@ -76,15 +100,37 @@ void sendResponse(int clientSock, const string &response)
 }
 
 /**
- * @brief Scans the graph input from the client.
+ * @brief Sends a whole chunk of a streamed response to the client.
+ * 
+ * @param clientSock The client's socket descriptor.
+ * @param data The bytes to send.
+ * @param size The number of bytes to send.
+ * @return bool True if every byte was sent, false if the connection failed.
+ */
+bool sendChunk(int clientSock, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = send(clientSock, data, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+/**
+ * @brief Scans the size of a new graph from the client input.
  * 
  * @param n Number of vertices.
  * @param m Number of edges.
  * @param ss The stringstream containing the client's input.
- * @param g Unique pointer to the graph object.
  * @return int 0 if successful, -1 otherwise.
  */
-int scanGraph(int &n, int &m, stringstream &ss, unique_ptr<Graph> &g)
+int scanGraph(int &n, int &m, stringstream &ss)
 {
     if (!(ss >> n >> m) || n <= 0 || m < 0)
     {
@@ -92,29 +138,63 @@ int scanGraph(int &n, int &m, stringstream &ss, unique_ptr<Graph> &g)
         cerr << "Invalid graph input" << endl;
         return -1;
     }
-
-    g = make_unique<Graph>(n, m);
     return 0;
 }
 
+/**
+ * @brief Creates a session with no graph yet.
+ * 
+ * @param calibrated The calibrated MST factory, whose cost model the factory of the session copies.
+ * @return shared_ptr<Session> The new session.
+ */
+shared_ptr<Session> newSession(const MSTFactory &calibrated)
+{
+    auto session = make_shared<Session>();
+    session->id = sessionCount.fetch_add(1, memory_order_relaxed);
+    session->factory.adoptCalibration(calibrated);
+    return session;
+}
+
+/**
+ * @brief Returns the session with the given name, creating it if no client joined it yet.
+ * 
+ * @param name The name of the session.
+ * @param calibrated The calibrated MST factory, used if the session is created.
+ * @return shared_ptr<Session> The named session.
+ */
+shared_ptr<Session> joinSession(const string &name, const MSTFactory &calibrated)
+{
+    unique_lock<mutex> guard(sessionsLock);
+    shared_ptr<Session> &session = namedSessions[name];
+    if (session == nullptr)
+    {
+        session = newSession(calibrated);
+    }
+    return session;
+}
+
 /**
  * @brief Handles commands sent by the client.
  * 
  * This function processes various commands related to graph operations and MST calculations.
  * Commands are handled asynchronously using the pipeline of ActiveObjects.
  * 
+ * The commands work on the session of the client: a session of its own until it joins a named one.
+ * 
  * @param clientSock The client's socket descriptor.
  * @param pipeline The pipeline of ActiveObjects for task execution.
- * @param g Unique pointer to the graph object.
- * @param factory The MSTFactory object for creating MSTs.
- * @param mst Unique pointer to the MST (Tree) object.
+ * @param calibrated The calibrated MST factory the sessions of the client copy their cost model from.
  */
-void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline, unique_ptr<Graph> &g, MSTFactory &factory, unique_ptr<Tree> &mst) 
+void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline, const MSTFactory &calibrated)
 {
     condition_variable cv;
     mutex ssLock;
     atomic<bool> done(false);
     char buffer[1024] = {0};
+    MSTFormat format = MSTFormat::Indented; // Layout of the MST in the responses of this client
+    int edgeOffset = 0; // First edge of the MST page sent to this client
+    int edgeLimit = -1; // Size of the MST page sent to this client, -1 for the whole tree
+    shared_ptr<Session> session = newSession(calibrated); // Graph, MST and factory the commands work on
 
     while (!terminateFlag.load()) 
     {
@@ -149,43 +229,12 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
 
         if (cmd == "Newgraph") 
         {
-            unique_lock<mutex> graphGuard(graphLock, try_to_lock);
-
-            if (!graphGuard.owns_lock()) 
-            {
-                sendResponse(clientSock, "Graph is being used by another thread. Cannot initialize new graph.\n");
-                continue;
-            }
-            if (g != nullptr) 
-            {
-                g.reset();
-                g = nullptr;
-            }
-            if (mst != nullptr) 
-            {
-                mst.reset();
-                mst = nullptr;
-            }
-
+            // The size and the edges are read on this thread without any lock, so a slow upload only holds up
+            // its own client, and the session's graph is replaced in one stage-0 task once they are all in
             int n, m, res = 0;
-            mutex initLock;
-            atomic<bool> initDone(false);
-            condition_variable initCV;
-
-            pipeline[0]->enqueue([&ss, &n, &m, &g, &ssLock, &initLock, &initDone, &initCV, &res]() 
-            {
-                unique_lock<mutex> guard2(ssLock);
-                unique_lock<mutex> guard(initLock);
-                res = scanGraph(n, m, ss, g);     
-                initDone.store(true, memory_order_release);
-                initCV.notify_one();
-            });
-
             {
-                unique_lock<mutex> guard(initLock);
-                while (!initDone) {
-                    initCV.wait(guard);
-                }
+                unique_lock<mutex> guard(ssLock);
+                res = scanGraph(n, m, ss);
             }
             if (res == -1) 
             {
@@ -193,6 +242,9 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                 continue;
             }
 
+            // Collect the edges so the whole upload is inserted by one task under one lock
+            vector<Edge> edges;
+            edges.reserve(m);
             for (int i = 0; i < m; i++) 
             {
                 int u = 0, v = 0, w = 0;
@@ -239,19 +291,26 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                     continue;
                 }
 
-                pipeline[0]->enqueue([&g, u, v, w]() 
-                {
-                    unique_lock<mutex> guard(graphLock);
-                    g->addEdge(u, v, w);
-                });
+                edges.push_back({u, v, w});
             }
 
+            // The reply is only sent once the edges are in, so the next command of the client sees the whole graph
+            pipeline[0]->enqueue(session->id, [session, n, m, edges = move(edges), &future, &done, &cv]()
             {
+                unique_lock<mutex> graphGuard(session->graphLock);
+                session->mst.reset();
+                session->factory.invalidate();
+                session->g = make_unique<Graph>(n, m);
+                int added = session->g->addEdges(edges);
+                {
+                    unique_lock<mutex> guard(coutLock);
+                    cout << "Edge index of the new graph uses " << session->g->edgeIndexBytes() << " bytes" << endl;
+                }
                 unique_lock<mutex> futureGuard(futureLock);
-                future = "\nGraph created with " + to_string(n) + " vertices and " + to_string(m) + " edges.\n";
+                future = "\nGraph created with " + to_string(n) + " vertices and " + to_string(added) + " edges.\n";
                 done.store(true, memory_order_release);
                 cv.notify_one();
-            }
+            });
         }
          else if (cmd == "AddEdge") 
         {
@@ -262,10 +321,10 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                 continue;
             }
 
-            pipeline[0]->enqueue([&g, u, v, w, &future, &done, &cv]() 
+            pipeline[0]->enqueue(session->id, [session, u, v, w, &future, &done, &cv]() 
             {
-                unique_lock<mutex> graphGuard(graphLock);
-                if (g == nullptr || g->getAdj().empty()) 
+                unique_lock<mutex> graphGuard(session->graphLock);
+                if (session->g == nullptr || session->g->getAdj().empty()) 
                 {
                     unique_lock<mutex> futureGuard(futureLock);
                     future = "Graph not initialized.\n";
@@ -273,7 +332,7 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                     cv.notify_one();
                     return;
                 }
-                bool success = g->addEdge(u, v, w);
+                bool success = session->g->addEdge(u, v, w);
                 unique_lock<mutex> futureGuard(futureLock);
                 if (!success) 
                 {
@@ -281,6 +340,8 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                 } 
                 else 
                 {
+                    // Keep the known MST up to date instead of recomputing it on the next query
+                    session->factory.edgeAdded(u, v, w);
                     future = "Edge added between vertices " + to_string(u) + " and " + to_string(v) + " with weight " + to_string(w) + ".\n";
                 }
                 done.store(true, memory_order_release);
@@ -297,10 +358,10 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                 continue;
             }
 
-            pipeline[0]->enqueue([&g, u, v, &future, &done, &cv]() 
+            pipeline[0]->enqueue(session->id, [session, u, v, &future, &done, &cv]() 
             {
-                unique_lock<mutex> graphGuard(graphLock);
-                if (g == nullptr || g->getAdj().empty()) 
+                unique_lock<mutex> graphGuard(session->graphLock);
+                if (session->g == nullptr || session->g->getAdj().empty()) 
                 {
                     unique_lock<mutex> futureGuard(futureLock);
                     future = "Graph not initialized.\n";
@@ -308,7 +369,7 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                     cv.notify_one();
                     return;
                 }
-                bool success = g->removeEdge(u, v);
+                bool success = session->g->removeEdge(u, v);
                 unique_lock<mutex> futureGuard(futureLock);
                 if (!success) 
                 {
@@ -316,6 +377,8 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                 } 
                 else 
                 {
+                    // Repair the known MST instead of recomputing it on the next query
+                    session->factory.edgeRemoved(*session->g, u, v);
                     future = "Edge removed between vertices " + to_string(u) + " and " + to_string(v) + ".\n";
                 }
                 done.store(true, memory_order_release);
@@ -324,11 +387,11 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
             
         }
          
-        else if (cmd == "Prim" || cmd == "Kruskal")
+        else if (session->factory.hasStrategy(cmd))
         {
-            pipeline[1]->enqueue([&g, cmd, &factory, &mst, &future, &done, &cv, &pipeline]()
+            pipeline[1]->enqueue([session, cmd, &future, &done, &cv, &pipeline, clientSock, format, edgeOffset, edgeLimit]()
             {
-                unique_lock<mutex> graphGuard(graphLock, try_to_lock);
+                unique_lock<mutex> graphGuard(session->graphLock, try_to_lock);
             if (!graphGuard.owns_lock()) 
             {
                 unique_lock<mutex> futureGuard(futureLock);
@@ -337,7 +400,7 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                 cv.notify_one();
                 return;
             }
-            if (g == nullptr || g->getAdj().empty()) 
+            if (session->g == nullptr || session->g->getAdj().empty()) 
             {
                 unique_lock<mutex> futureGuard(futureLock);
                 future = "Graph not initialized.\n";
@@ -346,22 +409,14 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                 return;
             }
 
-            if (mst != nullptr) 
+            if (session->mst != nullptr) 
             {
-                mst.reset();
-                mst = nullptr;
+                session->mst.reset();
+                session->mst = nullptr;
             }
 
-            if (cmd == "Prim") 
-            {
-                factory.setStrategy(new PrimStrategy);
-
-            }
-            else if (cmd == "Kruskal")
-            {
-                factory.setStrategy(new KruskalStrategy);
-            }
-            else 
+            // Strategies are registered once in the factory and reused by name
+            if (!session->factory.setStrategy(cmd))
             {
                 unique_lock<mutex> futureGuard(futureLock);
                 future = "Invalid command: " + cmd + "\n";
@@ -369,61 +424,189 @@ void handleCommands(int clientSock, vector<unique_ptr<ActiveObject>> &pipeline,
                 cv.notify_one();
                 return;
             }
-            pipeline[2]->enqueue([&g, &factory, &mst, &future, &done, &cv, &pipeline, cmd]()
+            pipeline[2]->enqueue([session, &future, &done, &cv, &pipeline, cmd, clientSock, format, edgeOffset, edgeLimit]()
             {
-                mst = factory.createMST(g);
+                // The metrics only read the finished tree, which no other task changes, so they run at the same
+                // time on stages 3 to 6 without holding any lock, and the join reports them in the usual order
+                shared_ptr<Tree> tree;
+                string header;
+                auto metrics = make_shared<TreeMetrics>();
+                auto metricGraph = make_shared<StageGraph>();
+                bool known = false;
                 {
-                    unique_lock<mutex> graphGuard(graphLock);
-                    unique_lock<mutex> futureGuard(futureLock);
-                    future += "MST created using " + cmd + " algorithm.\n";
-                    future += mst->printMST();
-                    
+                    unique_lock<mutex> graphGuard(session->graphLock);
+                    session->mst = session->factory.createMST(session->g);
+                    tree = session->mst;
+                    header = "MST created using " + (cmd == "Auto" ? "Auto (" + session->factory.lastStrategy() + ")" : cmd) + " algorithm.\n";
+                    // A tree handed out again by the cache already knows its metrics, and the graph stays empty
+                    if (const TreeMetrics* remembered = tree->rememberedMetrics())
+                    {
+                        *metrics = *remembered;
+                        known = true;
+                    }
+                    unique_lock<mutex> coutGuard(coutLock);
+                    cout << "[Server] MST cache: " << session->factory.cacheHits() << " hits, " << session->factory.cacheMisses() << " misses" << endl;
                 }
-                pipeline[3]->enqueue([&g, &mst, &future, &done, &cv, &pipeline]()
                 {
+                    // The client thread is waiting for the metrics, so the tree can be streamed to the socket in
+                    // chunks ahead of them instead of being built into the future. The tree does not change once
+                    // created, so it is written from the local copy without holding the graph lock
+                    sendResponse(clientSock, header);
+                    ChunkWriter out([clientSock](const char *data, size_t size) { return sendChunk(clientSock, data, size); });
+                    tree->writeMST(out, format, edgeOffset, edgeLimit);
+                    out.write("\n");
+                }
+                if (!known)
+                {
+                    unsigned cores = thread::hardware_concurrency();
+                    metricGraph->add(*pipeline[3], [tree, metrics]() { metrics->totalWeight = tree->computeTotalWeight(); });
+                    if (ParallelTreeMetrics::blocksFor(tree->getVerticesNumber(), cores) > 1)
                     {
-                        unique_lock<mutex> graphGuard(graphLock);
-                        unique_lock<mutex> futureGuard(futureLock);
-                        future += "TOTAL WEIGHT OF THE MST IS: ";
-                        future += to_string(mst->totalWeight()) + "\n\n";
-                        pipeline[4]->enqueue([&g, &mst, &future, &done, &cv, &pipeline]()
-                        {
-                            {
-                                unique_lock<mutex> graphGuard(graphLock);
-                                unique_lock<mutex> futureGuard(futureLock);
-                                future += "THE LONGEST PATH (DIAMETER) OF THE MST IS: ";
-                                future += to_string(mst->diameter()) + "\n\n";
-                                pipeline[5]->enqueue([&g, &mst, &future, &done, &cv, &pipeline]()
-                                {
-                                    {
-                                        unique_lock<mutex> graphGuard(graphLock);
-                                        unique_lock<mutex> futureGuard(futureLock);
-                                        future += "AVERAGE DISTANCE OF THE MST IS: ";
-                                        future += to_string(mst->averageDistanceEdges()) + "\n\n";
-                                        pipeline[6]->enqueue([&g, &mst, &future, &done, &cv, &pipeline]()
-                                        {
-                                            {
-                                                unique_lock<mutex> graphGuard(graphLock);
-                                                unique_lock<mutex> futureGuard(futureLock);
-
-                                                future += "SHORTEST PATH IS: ";
-                                                future += mst->shortestPath() + "\n";
-                                            }
-                                            {
-                                                unique_lock<mutex> futureGuard(futureLock);
-                                                done.store(true, memory_order_release);
-                                                cv.notify_one();
-                                            }
-                                        });
-                                    }
-                                });
-                            }
-                        });
+                        // A tree this large gets the diameter and the average distance from one scan on all the cores
+                        metricGraph->add(*pipeline[4], [tree, metrics, cores]() { tree->layoutMetrics(*metrics, cores); });
                     }
-
+                    else
+                    {
+                        metricGraph->add(*pipeline[4], [tree, metrics]() { metrics->diameter = tree->computeDiameter(); });
+                        metricGraph->add(*pipeline[5], [tree, metrics]() { metrics->averageDistance = tree->computeAverageDistance(); });
+                    }
+                    metricGraph->add(*pipeline[6], [tree, metrics]() { metrics->shortestPath = tree->computeShortestPath(); });
+                }
+                metricGraph->start([session, tree, metrics, known, &future, &done, &cv]()
+                {
+                    if (!known)
+                    {
+                        unique_lock<mutex> graphGuard(session->graphLock);
+                        tree->rememberMetrics(*metrics);
+                    }
+                    unique_lock<mutex> futureGuard(futureLock);
+                    future += "TOTAL WEIGHT OF THE MST IS: " + to_string(metrics->totalWeight) + "\n\n";
+                    future += "THE LONGEST PATH (DIAMETER) OF THE MST IS: " + to_string(metrics->diameter) + "\n\n";
+                    future += "AVERAGE DISTANCE OF THE MST IS: " + to_string(metrics->averageDistance) + "\n\n";
+                    future += "SHORTEST PATH IS: " + metrics->shortestPath + "\n";
+                    done.store(true, memory_order_release);
+                    cv.notify_one();
                 });
+            });
+            });
+        }
+        else if (cmd == "Session")
+        {
+            // Every task of this client has finished, so the session can be switched right away
+            string name;
+            if (ss >> name)
+            {
+                session = joinSession(name, calibrated);
+                sendResponse(clientSock, "Joined session " + name + ".\n");
+            }
+            else
+            {
+                session = newSession(calibrated);
+                sendResponse(clientSock, "Started a private session.\n");
+            }
+            continue;
+        }
+        else if (cmd == "Stats")
+        {
+            string stats;
+            for (size_t i = 0; i < pipeline.size(); i++)
+            {
+                char busy[16];
+                snprintf(busy, sizeof(busy), "%.1f", pipeline[i]->utilization() * 100);
+                stats += "Stage " + to_string(i) + ": " + to_string(pipeline[i]->workers()) + (pipeline[i]->workers() == 1 ? " worker, " : " workers, ")
+                    + to_string(pipeline[i]->executed()) + " tasks, " + busy + "% busy\n";
+            }
+            sendResponse(clientSock, stats);
+            continue;
+        }
+        else if (cmd == "Format")
+        {
+            string name;
+            ss >> name;
+            if (!parseMSTFormat(name, format))
+            {
+                sendResponse(clientSock, "Invalid format: " + name + ". Use Indented, Flat or Binary.\n");
+            }
+            else
+            {
+                sendResponse(clientSock, "MST output format set to " + name + ".\n");
+            }
+            continue;
+        }
+        else if (cmd == "Limit")
+        {
+            int limit = 0, offset = 0;
+            if (!(ss >> limit))
+            {
+                sendResponse(clientSock, "Invalid LIMIT input. Please provide the number of edges, -1 for all, and optionally an offset.\n");
+                continue;
+            }
+            ss >> offset;
+            edgeLimit = limit < 0 ? -1 : limit;
+            edgeOffset = max(offset, 0);
+            sendResponse(clientSock, edgeLimit < 0 && edgeOffset == 0 ? "MST output shows every edge.\n"
+                : "MST output shows " + (edgeLimit < 0 ? string("all") : to_string(edgeLimit)) + " edges starting at edge " + to_string(edgeOffset + 1) + ".\n");
+            continue;
+        }
+        else if (cmd == "Path")
+        {
+            int u = 0, v = 0;
+            if (!(ss >> u >> v))
+            {
+                sendResponse(clientSock, "Invalid PATH input. Please provide integers for u and v.\n");
+                continue;
+            }
 
+            // Path queries share the stage that reports the shortest path of an MST
+            pipeline[6]->enqueue([session, u, v, &future, &done, &cv]()
+            {
+                unique_lock<mutex> graphGuard(session->graphLock);
+                unique_lock<mutex> futureGuard(futureLock);
+                if (session->mst == nullptr)
+                {
+                    future = "No MST computed yet. Run an MST command first.\n";
+                }
+                else if (session->mst->distance(u, v) < 0)
+                {
+                    future = "No path between " + to_string(u) + " and " + to_string(v) + " in the MST.\n";
+                }
+                else
+                {
+                    // Answered from the LCA index of the MST, built on the first query
+                    future = "Path from " + to_string(u) + " to " + to_string(v) + ": " + session->mst->describePath(u, v);
+                }
+                done.store(true, memory_order_release);
+                cv.notify_one();
             });
+        }
+        else if (cmd == "Bottleneck")
+        {
+            int u = 0, v = 0;
+            if (!(ss >> u >> v))
+            {
+                sendResponse(clientSock, "Invalid BOTTLENECK input. Please provide integers for u and v.\n");
+                continue;
+            }
+
+            pipeline[6]->enqueue([session, u, v, &future, &done, &cv]()
+            {
+                unique_lock<mutex> graphGuard(session->graphLock);
+                unique_lock<mutex> futureGuard(futureLock);
+                optional<int> heaviest;
+                if (session->mst == nullptr)
+                {
+                    future = "No MST computed yet. Run an MST command first.\n";
+                }
+                else if (!(heaviest = session->mst->bottleneck(u, v)))
+                {
+                    future = "No edge between " + to_string(u) + " and " + to_string(v) + " in the MST.\n";
+                }
+                else
+                {
+                    future = "Bottleneck between " + to_string(u) + " and " + to_string(v) + ": heaviest edge weight " + to_string(*heaviest) + ".\n";
+                }
+                done.store(true, memory_order_release);
+                cv.notify_one();
             });
         }
         else if (cmd == "Exit") 
@@ -486,18 +669,31 @@ int acceptConnection(int server_sock)
  * manages connections using a pipeline of ActiveObjects, and
  * handles commands from clients in a multi-threaded environment.
  * 
+ * @param argc Number of command line arguments.
+ * @param argv The number of worker threads of every pipeline stage, in stage order; the stages
+ * not given run on one worker.
  * @return int Returns 0 on successful execution.
  */
-int main()
+int main(int argc, char *argv[])
 {
+    vector<unsigned> stageWorkers(7, 1);
+    for (int i = 1; i < argc && i <= 7; i++)
+    {
+        int workers = atoi(argv[i]);
+        if (workers < 1)
+        {
+            cerr << "Invalid number of workers for stage " << i - 1 << ": " << argv[i] << endl;
+            exit(1);
+        }
+        stageWorkers[i - 1] = workers;
+    }
+
     signal(SIGINT, signalHandler);
     vector<thread> threads;
     vector<unique_ptr<ActiveObject>> pipeline;
-    unique_ptr<Graph> g;
-    MSTFactory factory;
-    unique_ptr<Tree> mst;
+    MSTFactory factory; // Calibrated once, the cost model every session copies
     vector<pthread_t> clientThreads;
-    unique_ptr<functArgs> faPtr;
+    vector<unique_ptr<functArgs>> clientArgs; // One per client thread, so a new connection does not free the arguments of the last one
     
     signalHandlerLambda = [&](int signum)
     {
@@ -508,10 +704,9 @@ int main()
         }
         clientThreads.clear();
         clientThreads.shrink_to_fit();
-        faPtr.reset();
+        clientArgs.clear();
         factory.destroyStrategy();
-        mst.reset();
-        g.reset();
+        namedSessions.clear();
         for (auto &obj : pipeline)
         {
             obj.reset();
@@ -558,9 +753,24 @@ int main()
         cout << "MST pipeline server waiting for requests on port " << port << endl;
     }
 
+    {
+        unique_lock<mutex> guard(coutLock);
+        cout << "Calibrating the MST cost model" << endl;
+    }
+    factory.calibrate();
+
     for (int i = 0; i < 7; i++)
     {
-        pipeline.push_back(make_unique<ActiveObject>());
+        pipeline.push_back(make_unique<ActiveObject>(stageWorkers[i]));
+    }
+    {
+        unique_lock<mutex> guard(coutLock);
+        cout << "Workers per pipeline stage:";
+        for (unsigned workers : stageWorkers)
+        {
+            cout << " " << workers;
+        }
+        cout << endl;
     }
 
     while (true)
@@ -571,15 +781,15 @@ int main()
             continue;
         }
 
-        faPtr = unique_ptr<functArgs>(new functArgs{newClientSock, ref(pipeline), ref(g), ref(factory), ref(mst)});
+        clientArgs.push_back(unique_ptr<functArgs>(new functArgs{newClientSock, ref(pipeline), factory}));
         pthread_t tid;
         auto threadFunc = [](void *arg) -> void *
         {
             functArgs *fa = static_cast<functArgs *>(arg);
-            handleCommands(fa->clientSock, fa->pipeline, fa->g, fa->factory, fa->mst);
+            handleCommands(fa->clientSock, fa->pipeline, fa->calibrated);
             return nullptr;
         };
-        pthread_create(&tid, nullptr, threadFunc, faPtr.get());
+        pthread_create(&tid, nullptr, threadFunc, clientArgs.back().get());
         clientThreads.push_back(tid);
     }
     close(serverSock);
@@ -0,0 +1,63 @@
+#include "StageGraph.hpp"
+
+size_t StageGraph::add(ActiveObject& stage, Task work, const vector<size_t>& dependencies)
+{
+    size_t node = _nodes.size();
+    _nodes.push_back({&stage, move(work), {}, static_cast<int>(dependencies.size())});
+    for (size_t dependency : dependencies)
+    {
+        _nodes[dependency].dependents.push_back(node);
+    }
+    return node;
+}
+
+void StageGraph::start(Task join)
+{
+    _join = move(join);
+    if (_nodes.empty())
+    {
+        _join();
+        return;
+    }
+    _waiting.reset(new atomic<int>[_nodes.size()]);
+    for (size_t i = 0; i < _nodes.size(); i++)
+    {
+        _waiting[i].store(_nodes[i].dependencies, memory_order_relaxed);
+    }
+    _remaining.store(_nodes.size(), memory_order_release);
+    // Every counter is set before the first node can finish and read them
+    for (size_t i = 0; i < _nodes.size(); i++)
+    {
+        if (_nodes[i].dependencies == 0)
+        {
+            dispatch(i);
+        }
+    }
+}
+
+void StageGraph::dispatch(size_t node)
+{
+    _nodes[node].stage->enqueue([self = shared_from_this(), node]()
+    {
+        self->runNode(node);
+    });
+}
+
+void StageGraph::runNode(size_t node)
+{
+    _nodes[node].work();
+    _nodes[node].work.reset();
+    // The acquire-release decrements pass what the node wrote on to whoever runs next
+    for (size_t dependent : _nodes[node].dependents)
+    {
+        if (_waiting[dependent].fetch_sub(1, memory_order_acq_rel) == 1)
+        {
+            dispatch(dependent);
+        }
+    }
+    if (_remaining.fetch_sub(1, memory_order_acq_rel) == 1)
+    {
+        _join();
+        _join.reset();
+    }
+}
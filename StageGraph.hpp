@@ -0,0 +1,73 @@
+#ifndef _STAGEGRAPH_HPP
+#define _STAGEGRAPH_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "ActiveObject.hpp"
+using namespace std;
+
+/**
+ * @class StageGraph
+ *
+ * A directed acyclic graph of tasks, each run by the ActiveObject of a pipeline stage.
+ *
+ * A task is enqueued to its stage as soon as every task it depends on has finished, so tasks
+ * that do not depend on each other run at the same time on different stages instead of one
+ * after the other. Once the last task has finished, the join runs on the thread that finished
+ * it. Every task sees what its dependencies wrote, and the join sees what every task wrote.
+ *
+ * The graph is built with add, from a single thread, and then started once. It must be owned by
+ * a shared_ptr, which its tasks hold until the join has run, so the caller may drop it after start.
+ */
+class StageGraph : public enable_shared_from_this<StageGraph>
+{
+private:
+    struct Node
+    {
+        ActiveObject* stage; // Stage that runs the task
+        Task work; // The task
+        vector<size_t> dependents; // Nodes that wait for this one
+        int dependencies; // Number of nodes this one waits for
+    };
+
+    vector<Node> _nodes; // The tasks, in the order they were added
+    unique_ptr<atomic<int>[]> _waiting; // Unfinished dependencies of every node, once started
+    atomic<size_t> _remaining; // Number of nodes that have not finished
+    Task _join; // Runs after the last node
+
+    /*
+    * @brief Enqueues a node whose dependencies have all finished to its stage.
+    * @param node The index of the node.
+    * @return void
+    */
+    void dispatch(size_t node);
+
+    /*
+    * @brief Runs a node on the thread of its stage, then releases its dependents and, after the last node, the join.
+    * @param node The index of the node.
+    * @return void
+    */
+    void runNode(size_t node);
+
+public:
+    StageGraph() : _remaining(0) {}
+
+    /*
+    * @brief Adds a task to the graph.
+    * @param stage The stage that runs the task.
+    * @param work The task.
+    * @param dependencies The indices of the nodes that must finish before the task starts.
+    * @return size_t The index of the new node.
+    */
+    size_t add(ActiveObject& stage, Task work, const vector<size_t>& dependencies = {});
+
+    /*
+    * @brief Enqueues every task without dependencies. A graph without tasks runs the join right away.
+    * @param join The task to run once every node has finished.
+    * @return void
+    */
+    void start(Task join);
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "Task.hpp"
+#include <mutex>
+
+atomic<size_t> Task::_allocations(0);
+
+// The pool of free blocks is a list threaded through the blocks themselves. It is only used by
+// callables too large to be kept inline, so a mutex is cheap enough to guard it.
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+static mutex poolMx;
+static FreeBlock* freeBlocks = nullptr;
+
+// Hands the pooled blocks back to the heap when the program exits
+static struct PoolCleanup
+{
+    ~PoolCleanup()
+    {
+        while (freeBlocks != nullptr)
+        {
+            FreeBlock* block = freeBlocks;
+            freeBlocks = block->next;
+            ::operator delete(block);
+        }
+    }
+} poolCleanup;
+
+void* Task::acquire(size_t size)
+{
+    if (size <= BLOCK_SIZE)
+    {
+        lock_guard<mutex> lock(poolMx);
+        if (freeBlocks != nullptr)
+        {
+            FreeBlock* block = freeBlocks;
+            freeBlocks = block->next;
+            return block;
+        }
+    }
+    _allocations.fetch_add(1, memory_order_relaxed);
+    return ::operator new(size <= BLOCK_SIZE ? BLOCK_SIZE : size);
+}
+
+void Task::release(void* block, size_t size)
+{
+    if (size <= BLOCK_SIZE)
+    {
+        lock_guard<mutex> lock(poolMx);
+        freeBlocks = new (block) FreeBlock{freeBlocks};
+        return;
+    }
+    ::operator delete(block);
+}
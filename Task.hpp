@@ -0,0 +1,187 @@
+#ifndef _TASK_HPP
+#define _TASK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+/**
+ * @class Task
+ *
+ * A move-only callable taking no arguments, the unit of work of an ActiveObject.
+ *
+ * Unlike function<void()>, a Task never copies its callable and keeps it inline in a small buffer
+ * whenever it fits, which covers every lambda the pipeline stages enqueue, so creating, moving and
+ * running a task does not touch the heap. Larger callables are placed in fixed-size blocks taken
+ * from a shared pool that keeps released blocks for reuse, and only callables too large even for
+ * a block are allocated on their own. allocations() counts every heap allocation a Task has made,
+ * so a steady state without any can be checked.
+ */
+class Task
+{
+private:
+    static const size_t INLINE_SIZE = 112; // Bytes of callable kept inline, which makes a Task 128 bytes
+    static const size_t BLOCK_SIZE = 512; // Bytes of callable kept in a pooled block
+
+    /*
+    * Ops is what a Task needs to know about the type of its callable, one static instance per type.
+    */
+    struct Ops
+    {
+        void (*invoke)(void* storage); // Calls the callable
+        void (*relocate)(void* from, void* to); // Moves the callable from one storage to another, leaving from empty
+        void (*destroy)(void* storage); // Destroys the callable and releases its block, if any
+    };
+
+    /*
+    * Inline keeps the callable itself in the storage of the Task.
+    */
+    template <class F>
+    struct Inline
+    {
+        static void invoke(void* storage) { (*static_cast<F*>(storage))(); }
+        static void relocate(void* from, void* to)
+        {
+            F* callable = static_cast<F*>(from);
+            new (to) F(move(*callable));
+            callable->~F();
+        }
+        static void destroy(void* storage) { static_cast<F*>(storage)->~F(); }
+        static const Ops ops;
+    };
+
+    /*
+    * Boxed keeps the callable in a block of its own and only a pointer to it in the storage of the Task.
+    */
+    template <class F>
+    struct Boxed
+    {
+        static F*& callable(void* storage) { return *static_cast<F**>(storage); }
+        static void invoke(void* storage) { (*callable(storage))(); }
+        static void relocate(void* from, void* to) { callable(to) = callable(from); }
+        static void destroy(void* storage)
+        {
+            callable(storage)->~F();
+            release(callable(storage), sizeof(F));
+        }
+        static const Ops ops;
+    };
+
+    alignas(max_align_t) unsigned char _storage[INLINE_SIZE]; // The callable, or a pointer to its block
+    const Ops* _ops = nullptr; // Operations of the type of the callable, null for an empty Task
+    static atomic<size_t> _allocations; // Number of heap allocations made for callables
+
+    /*
+    * @brief Returns a block for a callable of the given size, from the pool if it fits in one.
+    * @param size The size of the callable in bytes.
+    * @return void* The block.
+    */
+    static void* acquire(size_t size);
+
+    /*
+    * @brief Returns a block taken by acquire, to the pool if it came from there.
+    * @param block The block.
+    * @param size The size of the callable it held, in bytes.
+    */
+    static void release(void* block, size_t size);
+
+public:
+    Task() = default;
+
+    /*
+    * @brief Wraps a callable, moving it into the Task.
+    * @param callable Any callable that can be called without arguments.
+    */
+    template <class F, class = enable_if_t<!is_same<decay_t<F>, Task>::value>>
+    Task(F&& callable)
+    {
+        using Callable = decay_t<F>;
+        static_assert(alignof(Callable) <= alignof(max_align_t), "Task does not support over-aligned callables");
+        // Moving an inline callable must not throw, since a Task moves it while being moved itself
+        if constexpr (sizeof(Callable) <= INLINE_SIZE && is_nothrow_move_constructible<Callable>::value)
+        {
+            new (_storage) Callable(forward<F>(callable));
+            _ops = &Inline<Callable>::ops;
+        }
+        else
+        {
+            void* block = acquire(sizeof(Callable));
+            try
+            {
+                Boxed<Callable>::callable(_storage) = new (block) Callable(forward<F>(callable));
+            }
+            catch (...)
+            {
+                release(block, sizeof(Callable));
+                throw;
+            }
+            _ops = &Boxed<Callable>::ops;
+        }
+    }
+
+    Task(Task&& other) noexcept
+    {
+        if (other._ops != nullptr)
+        {
+            other._ops->relocate(other._storage, _storage);
+            _ops = other._ops;
+            other._ops = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other._ops != nullptr)
+            {
+                other._ops->relocate(other._storage, _storage);
+                _ops = other._ops;
+                other._ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    /*
+    * @brief Destroys the callable, leaving the Task empty.
+    */
+    void reset()
+    {
+        if (_ops != nullptr)
+        {
+            _ops->destroy(_storage);
+            _ops = nullptr;
+        }
+    }
+
+    /*
+    * @brief Calls the callable. The Task must not be empty.
+    */
+    void operator()() { _ops->invoke(_storage); }
+
+    explicit operator bool() const { return _ops != nullptr; }
+
+    /*
+    * @brief Returns the number of heap allocations made for callables since the program started.
+    * Pooled blocks are counted once, when the pool first grows to need them.
+    */
+    static size_t allocations() { return _allocations.load(memory_order_relaxed); }
+};
+
+template <class F>
+const Task::Ops Task::Inline<F>::ops = {&Task::Inline<F>::invoke, &Task::Inline<F>::relocate, &Task::Inline<F>::destroy};
+
+template <class F>
+const Task::Ops Task::Boxed<F>::ops = {&Task::Boxed<F>::invoke, &Task::Boxed<F>::relocate, &Task::Boxed<F>::destroy};
+
+#endif
@@ -1,4 +1,5 @@
 #include "Tree.hpp"
+#include "ParallelMetrics.hpp"
 #include <queue>
 #include <vector>
 #include <string>
@@ -8,231 +9,460 @@
 
 using namespace std;
 
-void Tree::init(vector<Edge> edges)
+void Tree::init(int V, const vector<Edge>& edges)
 {
-    V = edges.size() + 1;
+    this->V = V;
     E = 0;
-    adj.resize(V);
+    edgeList.reserve(edges.size());
     
     for (const Edge& e : edges)
     {
         addEdge(e.src, e.dest, e.weight);
     }
+    // MSTFactory::createMST builds every tree it hands out through here, so the layout is ready up front
+    buildLayout();
 }
 
-int Tree::totalWeight()
+void Tree::buildLayout()
 {
-    int total = 0;
-    for (int i = 0; i < V; i++)
+    if (!layoutStale)
     {
-        for (Edge e : adj[i])
-        {
-            total += e.weight;
-        }
+        return;
     }
-    return total / 2;
-}
 
-vector<int> Tree::dijkstra(int src, vector<int> &parentTrack)
-{
-    // Create a priority queue to store vertices that are being preprocessed.
-    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
-    // Create a vector for distances and initialize all distances as infinite (INT_MAX)
-    vector<int> dist(V, INT_MAX);
-    // Insert source itself in priority queue and initialize its distance as 0.
-    pq.push({0, src});
-    dist[src - 1] = 0;
-    parentTrack[src - 1] = -1;
-
-    // Looping till priority queue becomes empty (or all distances are not finalized)
-    while (!pq.empty())
-    {
-        // The first vertex in pair is the minimum distance vertex, extract it from priority queue.
-        int u = pq.top().second - 1; // Convert to 0-based index
-        pq.pop();
-
-        // Loop through all adjacent of u
-        for (Edge e : adj[u])
+    // Bucket the edges by endpoint, keeping the order they were added in
+    vector<int> offsets(V + 1, 0);
+    for (const Edge& e : edgeList)
+    {
+        offsets[e.src]++;
+        offsets[e.dest]++;
+    }
+    for (int u = 0; u < V; u++)
+    {
+        offsets[u + 1] += offsets[u];
+    }
+    vector<int> slotEdge(offsets[V]); // Index in edgeList of every adjacency slot
+    vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < edgeList.size(); i++)
+    {
+        slotEdge[fill[edgeList[i].src - 1]++] = static_cast<int>(i);
+        slotEdge[fill[edgeList[i].dest - 1]++] = static_cast<int>(i);
+    }
+
+    vertexAt.clear();
+    parentAt.clear();
+    weightAt.clear();
+    vertexAt.reserve(V);
+    parentAt.reserve(V);
+    weightAt.reserve(V);
+    vector<int> positionOf(V, -1);
+
+    // Every frame is a vertex whose adjacency is being walked, next is the slot to look at
+    struct Frame {
+        int node;
+        int next;
+    };
+    vector<Frame> stack;
+    for (int root = 0; root < V; root++)
+    {
+        if (positionOf[root] != -1)
         {
-            int v = e.dest - 1; // Convert to 0-based index
-            int weight = e.weight;
-            // If there is a shorter path to v through u.
-            if (dist[v] > dist[u] + weight)
+            continue;
+        }
+        positionOf[root] = static_cast<int>(vertexAt.size());
+        vertexAt.push_back(root);
+        parentAt.push_back(-1);
+        weightAt.push_back(0);
+        stack.push_back({root, offsets[root]});
+        while (!stack.empty())
+        {
+            Frame& top = stack.back();
+            if (top.next == offsets[top.node + 1])
             {
-                // Updating distance of v
-                dist[v] = dist[u] + weight;
-                pq.push({dist[v], v + 1}); // Store as 1-based index
-                parentTrack[v] = u + 1; // Store parent as 1-based index
+                stack.pop_back();
+                continue;
             }
+            int node = top.node;
+            const Edge& e = edgeList[slotEdge[top.next++]];
+            int child = (e.src - 1 == node ? e.dest : e.src) - 1;
+            if (positionOf[child] != -1)
+            {
+                continue;
+            }
+            positionOf[child] = static_cast<int>(vertexAt.size());
+            vertexAt.push_back(child);
+            parentAt.push_back(positionOf[node]);
+            weightAt.push_back(e.weight);
+            stack.push_back({child, offsets[child]});
         }
     }
-    return dist;
+    layoutEdges = static_cast<int>(count_if(parentAt.begin(), parentAt.end(), [](int p) { return p != -1; }));
+    layoutStale = false;
 }
 
-void Tree::dfs(int node, int parent, vector<int> &dist, vector<int> &parentTrack)
+void Tree::layoutMetrics(TreeMetrics& metrics, unsigned threads) const
 {
-    for (Edge e : adj[node - 1])
+    int n = static_cast<int>(vertexAt.size());
+    unsigned blocks = ParallelTreeMetrics::blocksFor(n, threads);
+    if (blocks > 1)
     {
-        if (e.dest != parent)
-        {
-            dist[e.dest - 1] = dist[node - 1] + e.weight;
-            parentTrack[e.dest - 1] = node;
-            dfs(e.dest, node, dist, parentTrack);
-        }
+        ParallelTreeMetrics parallel(parentAt, weightAt, blocks);
+        metrics.diameter = static_cast<int>(parallel.diameter());
+        metrics.averageDistance = static_cast<float>(static_cast<long double>(parallel.pairDistanceSum()) / parallel.pairCount());
+    }
+    else
+    {
+        SequentialTreeMetrics sequential(parentAt, weightAt);
+        metrics.diameter = static_cast<int>(sequential.diameter());
+        metrics.averageDistance = static_cast<float>(static_cast<long double>(sequential.pairDistanceSum()) / sequential.pairCount());
     }
 }
 
-string Tree::shortestPath()
+int Tree::computeTotalWeight() const
 {
-    // Initialize minimum weight as maximum possible integer value
-    int minWeight = INT_MAX;
-    int u = -1, v = -1;
+    long long weight = 0;
+    for (const Edge& e : edgeList)
+    {
+        weight += e.weight;
+    }
+    return static_cast<int>(weight);
+}
 
-    // Find the edge with the least weight
-    for (int i = 0; i < V; i++)
+int Tree::computeDiameter() const
+{
+    // Only the component of vertex 1 counts, the range of the layout before the second root
+    int end = vertexAt.empty() ? 0 : 1;
+    while (end < static_cast<int>(vertexAt.size()) && parentAt[end] != -1)
     {
-        for (Edge e : adj[i])
+        end++;
+    }
+    vector<long long> down(end, 0);
+    long long longest = 0;
+    for (int k = end - 1; k > 0; k--)
+    {
+        int p = parentAt[k];
+        long long w = weightAt[k];
+        longest = max(longest, down[p] + down[k] + w);
+        down[p] = max(down[p], down[k] + w);
+    }
+    return static_cast<int>(longest);
+}
+
+float Tree::computeAverageDistance() const
+{
+    int n = static_cast<int>(vertexAt.size());
+    vector<int> componentStart;
+    for (int k = 0; k < n; k++)
+    {
+        if (parentAt[k] == -1)
         {
-            if (e.weight < minWeight)
-            {
-                minWeight = e.weight;
-                u = e.src;
-                v = e.dest;
-            }
+            componentStart.push_back(k);
         }
     }
 
-    // If no valid edge was found, return no path
-    if (u == -1 || v == -1)
+    // The reverse scan of SequentialTreeMetrics without the chains of the diameter
+    vector<long long> size(n, 1);
+    __int128 pairSum = 0;
+    long long pairs = 0;
+    for (size_t c = 0; c < componentStart.size(); c++)
     {
-        return "No path found\n";
+        int begin = componentStart[c];
+        int end = c + 1 < componentStart.size() ? componentStart[c + 1] : n;
+        long long members = end - begin;
+        for (int k = end - 1; k > begin; k--)
+        {
+            pairSum += static_cast<__int128>(weightAt[k]) * (size[k] * (members - size[k]));
+            size[parentAt[k]] += size[k];
+        }
+        pairs += members * (members - 1) / 2;
     }
-
-    // Use the existing Dijkstra algorithm to find the shortest path between u and v
-    vector<int> parentTrack(V, -1);
-    vector<int> dist = dijkstra(u, parentTrack);
-
-    // Return the reconstructed path
-    return reconstructPath(u, v, parentTrack, dist[v - 1]);
+    return static_cast<float>(static_cast<long double>(pairSum) / pairs);
 }
 
-
-string Tree::reconstructPath(int src, int dest, const vector<int> &parentTrack, int totalWeight)
+string Tree::computeShortestPath() const
 {
-    int dest_index = dest - 1; // Convert to 0-based index
-    if (parentTrack[dest_index] == -1)
+    // The shortest path reported is the lightest edge. The adjacency order used to pick among equal
+    // weights is: smallest endpoint first, then the edge added first, printed from that endpoint.
+    const Edge* lightest = nullptr;
+    int from = 0;
+    for (const Edge& e : edgeList)
     {
-        return "No path";
+        int low = min(e.src, e.dest);
+        if (lightest == nullptr || e.weight < lightest->weight || (e.weight == lightest->weight && low < from))
+        {
+            lightest = &e;
+            from = low;
+        }
+    }
+    if (lightest == nullptr || lightest->weight == INT_MAX)
+    {
+        return "No path found\n";
     }
+    int to = lightest->src == from ? lightest->dest : lightest->src;
+    return to_string(from) + " -> " + to_string(to) + " (" + to_string(lightest->weight) + ")\n";
+}
 
-    vector<int> path;
-    for (int i = dest_index; i != -1; i = parentTrack[i] - 1)
+const TreeMetrics& Tree::computeMetrics(unsigned threads)
+{
+    if (metricsMemo)
     {
-        path.push_back(i + 1); // Store as 1-based index
-        if (i == src - 1) break;  // Stop if we have reached the source
+        return *metricsMemo;
     }
+    buildLayout();
+    TreeMetrics metrics;
+    layoutMetrics(metrics, threads);
+    metrics.totalWeight = computeTotalWeight();
+    metrics.shortestPath = computeShortestPath();
+    metricsMemo = move(metrics);
+    return *metricsMemo;
+}
 
-    if (path.back() != src)
+void Tree::rememberMetrics(const TreeMetrics& metrics)
+{
+    if (!metricsMemo)
     {
-        return "No path";
+        metricsMemo = metrics;
     }
+}
 
-    reverse(path.begin(), path.end());
-    string result;
+int Tree::totalWeight()
+{
+    return computeMetrics().totalWeight;
+}
+
+string Tree::shortestPath()
+{
+    return computeMetrics().shortestPath;
+}
+
+float Tree::averageDistanceEdges()
+{
+    return computeMetrics().averageDistance;
+}
 
-    for (size_t i = 0; i < path.size(); i++)
+int Tree::diameter()
+{
+    return computeMetrics().diameter;
+}
+
+void Tree::buildIndex()
+{
+    if (!indexStale)
+    {
+        return;
+    }
+    buildLayout();
+    up.assign(V, -1);
+    depth.assign(V, 0);
+    rootDistance.assign(V, 0);
+    component.assign(V, -1);
+    preorder.assign(V, 0);
+    chainHead.assign(V, 0);
+    vector<int> upWeight(V, 0); // Weight of the edge between every vertex and its parent
+    for (int k = 0; k < V; k++)
     {
-        result += to_string(path[i]);
-        if (i < path.size() - 1)
+        int v = vertexAt[k];
+        if (parentAt[k] == -1)
         {
-            result += " -> ";
+            component[v] = v;
+            continue;
         }
+        int u = vertexAt[parentAt[k]];
+        component[v] = component[u];
+        up[v] = u;
+        upWeight[v] = weightAt[k];
+        depth[v] = depth[u] + 1;
+        rootDistance[v] = rootDistance[u] + weightAt[k];
     }
-    result += " (" + to_string(totalWeight) + ")\n";  // Include the total weight
-    return result;
-}
 
-
-void Tree::floydWarshall()
-{
-    distanceMap.resize(V, vector<int>(V, INT_MAX));
-    for (int i = 0; i < V; i++)
+    // The heavy child of a position is the child with the largest subtree
+    vector<int> size(V, 1);
+    vector<int> heavy(V, -1);
+    for (int k = V - 1; k >= 0; k--)
     {
-        distanceMap[i][i] = 0;
-        for (Edge e : adj[i])
+        int p = parentAt[k];
+        if (p != -1)
         {
-            distanceMap[i][e.dest - 1] = e.weight;
+            size[p] += size[k];
+            if (heavy[p] == -1 || size[k] > size[heavy[p]])
+            {
+                heavy[p] = k;
+            }
         }
     }
 
-    for (int k = 0; k < V; k++)
+    // A DFS that visits the heavy child first gives a preorder in which every subtree and every
+    // heavy chain is a contiguous range, so the LCA and the path maximum share one numbering.
+    // In the layout the first child of k sits at k + 1 and every next sibling right after the
+    // subtree of the previous one, so the children are found without an adjacency list.
+    vector<int> order;
+    order.reserve(V);
+    vector<int> stack;
+    for (int root = 0; root < V; root++)
     {
-        for (int i = 0; i < V; i++)
+        if (parentAt[root] != -1)
         {
-            for (int j = 0; j < V; j++)
+            continue;
+        }
+        chainHead[vertexAt[root]] = vertexAt[root];
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            int k = stack.back();
+            stack.pop_back();
+            int u = vertexAt[k];
+            preorder[u] = static_cast<int>(order.size());
+            order.push_back(u);
+            for (int c = k + 1; c < V && parentAt[c] == k; c += size[c])
             {
-                if (distanceMap[i][k] != INT_MAX && distanceMap[k][j] != INT_MAX &&
-                    distanceMap[i][j] > distanceMap[i][k] + distanceMap[k][j])
+                if (c != heavy[k])
                 {
-                    distanceMap[i][j] = distanceMap[i][k] + distanceMap[k][j];
+                    chainHead[vertexAt[c]] = vertexAt[c];
+                    stack.push_back(c);
                 }
             }
+            if (heavy[k] != -1)
+            {
+                chainHead[vertexAt[heavy[k]]] = chainHead[u];
+                stack.push_back(heavy[k]);
+            }
         }
     }
-}
 
-float Tree::averageDistanceEdges()
-{
-    floydWarshall();
-    int total = 0;
-    int count = 0;
+    // shallowest[k][i] is the shallowest vertex among order[i .. i + 2^k - 1],
+    // heaviest[k][i] the heaviest edge to a parent among the same vertices
+    shallowest.assign(1, order);
+    heaviest.assign(1, vector<int>(V));
     for (int i = 0; i < V; i++)
     {
-        for (int j = i + 1; j < V; j++)
+        heaviest[0][i] = upWeight[order[i]];
+    }
+    for (int k = 1; (1 << k) <= V; k++)
+    {
+        const vector<int>& prev = shallowest[k - 1];
+        const vector<int>& prevMax = heaviest[k - 1];
+        int half = 1 << (k - 1);
+        vector<int> level(V - (1 << k) + 1);
+        vector<int> levelMax(level.size());
+        for (size_t i = 0; i < level.size(); i++)
         {
-            if (distanceMap[i][j] != INT_MAX)
-            {
-                total += distanceMap[i][j];
-                count++;
-            }
+            int a = prev[i], b = prev[i + half];
+            level[i] = depth[a] <= depth[b] ? a : b;
+            levelMax[i] = max(prevMax[i], prevMax[i + half]);
         }
+        shallowest.push_back(move(level));
+        heaviest.push_back(move(levelMax));
     }
-    
-    return static_cast<float>(total) / count;
+    indexStale = false;
 }
 
+int Tree::lca(int u, int v) const
+{
+    if (u == v)
+    {
+        return u;
+    }
+    int l = preorder[u], r = preorder[v];
+    if (l > r)
+    {
+        swap(l, r);
+    }
+    l++;
+    int k = 31 - __builtin_clz(r - l + 1);
+    int a = shallowest[k][l], b = shallowest[k][r - (1 << k) + 1];
+    return up[depth[a] <= depth[b] ? a : b];
+}
 
-pair<int, int> Tree::farthestNode(int start)
+long long Tree::distance(int u, int v)
 {
-    vector<int> dist(V, -1);
-    vector<int> parentTrack(V, -1);
-    dist[start - 1] = 0;
+    if (u < 1 || u > V || v < 1 || v > V)
+    {
+        return -1;
+    }
+    buildIndex();
+    u--, v--;
+    if (component[u] != component[v])
+    {
+        return -1;
+    }
+    return rootDistance[u] + rootDistance[v] - 2 * rootDistance[lca(u, v)];
+}
 
-    dfs(start, -1, dist, parentTrack);
+int Tree::heaviestIn(int l, int r) const
+{
+    int k = 31 - __builtin_clz(r - l + 1);
+    return max(heaviest[k][l], heaviest[k][r - (1 << k) + 1]);
+}
 
-    int maxDist = -1;
-    int farthest = start;
-    for (int i = 0; i < V; ++i)
+optional<int> Tree::bottleneck(int u, int v)
+{
+    if (u == v || distance(u, v) < 0)
     {
-        if (dist[i] > maxDist)
+        return nullopt;
+    }
+    u--, v--;
+    int result = INT_MIN;
+    // Climb from the endpoint whose chain starts deeper until both lie on the same heavy chain
+    while (chainHead[u] != chainHead[v])
+    {
+        if (depth[chainHead[u]] < depth[chainHead[v]])
         {
-            maxDist = dist[i];
-            farthest = i + 1;
+            swap(u, v);
         }
+        result = max(result, heaviestIn(preorder[chainHead[u]], preorder[u]));
+        u = up[chainHead[u]];
     }
-
-    return {farthest, maxDist};
+    if (u != v)
+    {
+        // The upper endpoint's own parent edge is not on the path
+        result = max(result, heaviestIn(min(preorder[u], preorder[v]) + 1, max(preorder[u], preorder[v])));
+    }
+    return result;
 }
 
-int Tree::diameter()
+vector<int> Tree::path(int u, int v)
 {
-    // Step 1: Find the farthest node from an arbitrary starting node (e.g., node 1)
-    auto [farthestNodeFromStart, _] = farthestNode(1);
+    vector<int> result;
+    if (distance(u, v) < 0)
+    {
+        return result;
+    }
+    u--, v--;
+    int top = lca(u, v);
+    for (int x = u; x != top; x = up[x])
+    {
+        result.push_back(x + 1);
+    }
+    result.push_back(top + 1);
+    size_t climb = result.size();
+    for (int x = v; x != top; x = up[x])
+    {
+        result.push_back(x + 1);
+    }
+    // The part climbed from v was collected bottom-up
+    reverse(result.begin() + climb, result.end());
+    return result;
+}
 
-    // Step 2: Find the farthest node from the first farthest node found
-    auto [farthestNodeFromFarthest, diameterLength] = farthestNode(farthestNodeFromStart);
+string Tree::describePath(int u, int v)
+{
+    vector<int> vertices = path(u, v);
+    if (vertices.empty())
+    {
+        return "No path";
+    }
 
-    return diameterLength;
+    string result;
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        result += to_string(vertices[i]);
+        if (i < vertices.size() - 1)
+        {
+            result += " -> ";
+        }
+    }
+    result += " (" + to_string(distance(u, v)) + ")\n";  // Include the total weight
+    return result;
 }
 
 bool Tree::addEdge(int u, int v, int w)
@@ -255,9 +485,13 @@ bool Tree::addEdge(int u, int v, int w)
         exit(1);
     }
 
-    adj[u - 1].push_back({u, v, w});
-    adj[v - 1].push_back({v, u, w});
+    edgeList.push_back({u, v, w});
     E++;
+    version = nextVersion();
+    layoutStale = true;
+    indexStale = true;
+    metricsMemo.reset();
+    layoutMemo.reset();
     return true;
 }
 
@@ -268,44 +502,83 @@ void Tree::removeEdge(int u, int v)
 
 string Tree::printMST()
 {
-    vector<bool> visited(V, false);
-    return printMST(0, -1, 0, visited) + "\n";
+    if (!layoutMemo)
+    {
+        string result;
+        {
+            ChunkWriter out([&result](const char* data, size_t size) { result.append(data, size); return true; });
+            writeMST(out, MSTFormat::Indented);
+        }
+        layoutMemo = result + "\n";
+    }
+    return *layoutMemo;
 }
 
-string Tree::printMST(int node, int parent, int level, vector<bool>& visited)
+int Tree::writeMST(ChunkWriter& out, MSTFormat format, int offset, int limit)
 {
-    string result;
-    if (level == 0) {
-        result += "------------------\n";
+    buildLayout();
+    int total = layoutEdges;
+    offset = max(0, min(offset, total));
+    int count = limit < 0 ? total - offset : min(limit, total - offset);
+    int last = offset + count; // Edges are numbered in layout order, [offset, last) are written
+    if (format == MSTFormat::Indented)
+    {
+        out.write("------------------\n");
+    }
+    else if (format == MSTFormat::Binary)
+    {
+        out.write("BINARY " + to_string(count) + " " + to_string(total) + "\n");
     }
-    
-    visited[node] = true;
 
-    for (auto& edge : adj[node])
+    vector<int> level(format == MSTFormat::Indented ? V : 0); // Depth of every position, for the indentation
+    int edge = 0;
+    for (int k = 0; k < V && edge < last && out.ok(); k++)
     {
-        if (!visited[edge.dest - 1])
+        int p = parentAt[k];
+        if (p == -1)
         {
-            // Use indentation to visually represent tree levels
-            string indentation(level * 4, ' '); // Use 4 spaces per level for clarity
-
-            // Format the output with clearer connection symbols and descriptions
-            result += indentation + "|- Node " + to_string(node + 1) + " -> Node " + to_string(edge.dest) + " [weight: " + to_string(edge.weight) + "]\n";
-            
-            // Add an extra blank line for more spacing between connections
-            result += "\n";
-            
-            // Recursively print the subtree with incremented level
-            result += printMST(edge.dest - 1, node, level + 1, visited);
+            continue;
+        }
+        if (format == MSTFormat::Indented)
+        {
+            level[k] = level[p] + 1;
+        }
+        if (edge++ < offset)
+        {
+            continue;
         }
-    }
 
-    if (level == 0) {
-        result += "--------------------\n";
+        int node = vertexAt[p] + 1, child = vertexAt[k] + 1;
+        if (format == MSTFormat::Indented)
+        {
+            // Use indentation to visually represent tree levels, 4 spaces per level for clarity,
+            // and an extra blank line for more spacing between connections
+            out.fill(' ', level[p] * 4);
+            out.write("|- Node " + to_string(node) + " -> Node " + to_string(child) + " [weight: " + to_string(weightAt[k]) + "]\n\n");
+        }
+        else if (format == MSTFormat::Flat)
+        {
+            out.write(to_string(node) + " " + to_string(child) + " " + to_string(weightAt[k]) + "\n");
+        }
+        else
+        {
+            out.writeInt32(node);
+            out.writeInt32(child);
+            out.writeInt32(weightAt[k]);
+        }
     }
 
-    return result;
+    if (format != MSTFormat::Binary && count == 0 && total > 0)
+    {
+        out.write("... showing none of " + to_string(total) + " edges\n");
+    }
+    else if (format != MSTFormat::Binary && count < total)
+    {
+        out.write("... showing edges " + to_string(offset + 1) + " to " + to_string(last) + " of " + to_string(total) + "\n");
+    }
+    if (format == MSTFormat::Indented)
+    {
+        out.write("--------------------\n");
+    }
+    return count;
 }
-
-
-
-
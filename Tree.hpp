@@ -3,82 +3,103 @@
 
 #include <limits.h>
 #include "Graph.hpp"
+#include "TreeWriter.hpp"
 #include <queue>
 #include <utility>
 #include <vector>
+#include <optional>
+#include <string>
+
+/**
+ * @struct TreeMetrics
+ * 
+ * @brief The metrics the servers report for every MST, computed together by Tree::computeMetrics.
+ */
+struct TreeMetrics {
+    int totalWeight = 0;       ///< Sum of the edge weights
+    int diameter = 0;          ///< Longest path in the component of vertex 1
+    float averageDistance = 0; ///< Average distance over all pairs of connected vertices
+    string shortestPath;       ///< The lightest edge formatted as a path, "u -> v (w)"
+};
 
 class Tree : public Graph
 {
     private:
-        vector<vector<int>> distanceMap; ///< Stores distances between all pairs of vertices for the Floyd-Warshall algorithm.
+        vector<Edge> edgeList; ///< The edges in the order they were added, the source of the layout.
+
+        // Compact rooted layout: the vertices in DFS preorder, one component after the other, with the
+        // children of every vertex in the order their edges were added. A position holds a vertex and
+        // the edge to its parent, so every traversal is a linear scan over these three arrays.
+        vector<int> vertexAt; ///< 0-based vertex at every position.
+        vector<int> parentAt; ///< Position of the parent of every position, -1 for the root of a component.
+        vector<int> weightAt; ///< Weight of the edge to the parent of every position, 0 for a root.
+        int layoutEdges = 0; ///< Number of positions that are not roots, the edges of the layout.
+        bool layoutStale = true; ///< True if edges were added since the layout was built.
+        optional<TreeMetrics> metricsMemo; ///< Result of computeMetrics, once computed.
+        optional<string> layoutMemo; ///< Output of printMST, once computed.
+        vector<int> up; ///< Parent of every vertex in the LCA index, -1 for the root of each component.
+        vector<int> depth; ///< Number of edges between every vertex and the root of its component.
+        vector<long long> rootDistance; ///< Weighted depth: total weight of the path from the root of the component.
+        vector<int> component; ///< Root of the component of every vertex.
+        vector<int> preorder; ///< Position of every vertex in the DFS preorder.
+        vector<int> chainHead; ///< Topmost vertex of the heavy chain of every vertex.
+        vector<vector<int>> shallowest; ///< Sparse table: shallowest vertex of every power-of-two range of the preorder.
+        vector<vector<int>> heaviest; ///< Sparse table: heaviest parent edge of every power-of-two range of the preorder.
+        bool indexStale = true; ///< True if edges were added since the LCA index was built.
 
         /**
-         * @brief Performs a depth-first search (DFS) to calculate distances from a node.
-         * 
-         * This function calculates the distance of all nodes from a given
-         * starting node using DFS and updates the distance and parent tracking vectors.
+         * @brief Builds the rooted layout, if edges were added since it was last built.
          * 
-         * @param node The current node being visited.
-         * @param parent The parent node of the current node.
-         * @param dist A reference to a vector that stores distances from the start node.
-         * @param parentTrack A reference to a vector that tracks the parents of each vertex.
+         * The edge list is bucketed by endpoint into a temporary adjacency, in the order the edges
+         * were added, and an iterative DFS from vertex 1 (then from the first vertex of every other
+         * component) lays the vertices out in preorder. The adjacency is released afterwards, so a
+         * built tree keeps only the edge list and the three layout arrays.
          */
-        void dfs(int node, int parent, vector<int>& dist, vector<int>& parentTrack);
+        void buildLayout();
 
         /**
-         * @brief Finds the farthest node from a given starting node.
+         * @brief Builds the LCA and heavy-light index of the tree, if edges were added since it was last built.
          * 
-         * This function performs a DFS from a given starting node and returns
-         * the farthest node found and the distance to that node.
-         * 
-         * @param start The starting node.
-         * @return pair<int, int> A pair containing the farthest node and its distance.
+         * A forward scan of the layout records the parent, depth and weighted depth of every vertex, and
+         * a reverse scan its subtree size. A DFS over the layout then visits the heavy child (largest
+         * subtree) first, so its preorder keeps every subtree and every heavy chain contiguous. Two sparse tables over that preorder then answer "shallowest
+         * vertex" and "heaviest parent edge" of a range in O(1). The index takes O(V log V) time and memory
+         * and is kept until an edge is added.
          */
-        pair<int, int> farthestNode(int start);
+        void buildIndex();
 
         /**
-         * @brief Implements Dijkstra's algorithm to find the shortest paths from a source vertex.
+         * @brief Returns the lowest common ancestor of two vertices of the same component.
          * 
-         * This function computes the shortest path from a given source vertex to all other vertices
-         * using Dijkstra's algorithm. It returns the distance vector and updates the parent tracking vector.
+         * For u != v with u earlier in the preorder, the LCA is the parent of the shallowest vertex
+         * after u up to and including v in the preorder, which is one sparse table lookup.
          * 
-         * @param src The source vertex.
-         * @param parentTrack A reference to a vector that tracks the parents of each vertex.
-         * @return vector<int> The vector of shortest distances from the source vertex.
+         * @param u 0-based vertex.
+         * @param v 0-based vertex in the same component as u.
+         * @return int The 0-based lowest common ancestor.
          */
-        vector<int> dijkstra(int src, vector<int> &parentTrack);
+        int lca(int u, int v) const;
 
         /**
-         * @brief Implements Floyd-Warshall algorithm to compute all-pairs shortest paths.
+         * @brief Returns the heaviest parent edge of the vertices at preorder positions l .. r.
          * 
-         * This function calculates the shortest paths between all pairs of vertices in the tree
-         * and stores the results in a distance matrix.
+         * @param l First position, inclusive.
+         * @param r Last position, inclusive, not smaller than l.
+         * @return int The largest weight, found with one sparse table lookup.
          */
-        void floydWarshall();
+        int heaviestIn(int l, int r) const;
+
 
         /**
          * @brief Initializes the Tree with a given set of edges.
          * 
          * This function sets up the tree by adding all the edges provided
-         * in the input vector to the adjacency list.
+         * in the input vector to the edge list, then builds the rooted layout.
          * 
+         * @param V Number of vertices in the tree.
          * @param edges A vector of edges to initialize the tree.
          */
-        void init(vector<Edge> edges);
-
-        /**
-         * @brief Helper function to recursively print the MST.
-         * 
-         * This function recursively traverses the tree to generate a structured representation
-         * of the MST, with indentation to show the levels of the tree.
-         * 
-         * @param node The current node being visited.
-         * @param parent The parent node of the current node.
-         * @param level The current depth level in the tree.
-         * @param visited A reference to a vector tracking visited nodes.
-         * @return string A formatted string representing the MST.
-         */
-        string printMST(int node, int parent, int level, vector<bool>& visited);
+        void init(int V, const vector<Edge>& edges);
 
     public:
         /**
@@ -93,66 +114,172 @@ class Tree : public Graph
          * 
          * @param edges A vector of edges to initialize the tree.
          */
-        Tree(vector<Edge> edges): Graph() { init(edges); }
+        Tree(vector<Edge> edges): Graph() { init(edges.size() + 1, edges); }
 
         /**
-         * @brief Calculates the total weight of the tree.
+         * @brief Parameterized constructor for the Tree class.
          * 
-         * This function sums the weights of all edges in the tree and returns
-         * the total weight. The sum is divided by 2 since each edge is counted twice
-         * in the adjacency list.
+         * Initializes a tree (or a forest, if there are fewer than V - 1 edges) over
+         * V vertices with a given set of edges.
+         * 
+         * @param V Number of vertices.
+         * @param edges A vector of edges to initialize the tree.
+         */
+        Tree(int V, vector<Edge> edges): Graph() { init(V, edges); }
+
+        /**
+         * @brief Computes all the metrics the servers report, in one scan of the layout.
+         * 
+         * In the layout every parent comes before its children, so a single reverse scan of it
+         * accumulates the subtree sizes for the average distance (every edge lies on the path of
+         * size * (n - size) pairs, summed in 128 bits since this grows like V^3 on a path) and the
+         * longest downward chain of every vertex for the diameter. A scan of the edge list gives the
+         * total weight and the lightest edge. The result is remembered until an edge is added, so a
+         * tree handed out again by a cache answers in O(1).
+         * With more than one thread, a tree large enough to gain from it is handed to
+         * ParallelTreeMetrics instead of the reverse scan, which gives exactly the same results.
+         * 
+         * @param threads The number of threads the diameter and the average distance may use.
+         * @return const TreeMetrics& The metrics of the tree.
+         */
+        const TreeMetrics& computeMetrics(unsigned threads = 1);
+
+        /**
+         * @brief Computes the diameter and the average distance, as computeMetrics does, without remembering them.
+         * 
+         * Like the other const metric functions below it only reads the layout, so any number of
+         * threads may call them at once on a tree whose edges were all given to its constructor.
+         * 
+         * @param metrics Receives the diameter and the average distance.
+         * @param threads The number of threads the scan may use.
+         */
+        void layoutMetrics(TreeMetrics& metrics, unsigned threads) const;
+
+        /**
+         * @brief Computes the total weight with one scan of the edge list, without remembering it.
          * 
          * @return int The total weight of the tree.
          */
+        int computeTotalWeight() const;
+
+        /**
+         * @brief Computes the diameter with one reverse scan of the first component of the layout, without remembering it.
+         * 
+         * @return int The diameter of the component of vertex 1.
+         */
+        int computeDiameter() const;
+
+        /**
+         * @brief Computes the average distance with one reverse scan of the layout, without remembering it.
+         * 
+         * @return float The average distance over all pairs of connected vertices.
+         */
+        float computeAverageDistance() const;
+
+        /**
+         * @brief Finds the lightest edge with one scan of the edge list, without remembering it.
+         * 
+         * @return string The lightest edge formatted as a path, "u -> v (w)".
+         */
+        string computeShortestPath() const;
+
+        /**
+         * @brief Returns the metrics remembered by computeMetrics or rememberMetrics.
+         * 
+         * @return const TreeMetrics* The metrics, or nullptr if none are remembered.
+         */
+        const TreeMetrics* rememberedMetrics() const { return metricsMemo ? &*metricsMemo : nullptr; }
+
+        /**
+         * @brief Remembers metrics computed with the const metric functions, so computeMetrics answers from them.
+         * 
+         * @param metrics The metrics of the tree.
+         */
+        void rememberMetrics(const TreeMetrics& metrics);
+
+        /**
+         * @brief Calculates the total weight of the tree.
+         * 
+         * @return int The total weight of the tree, taken from computeMetrics.
+         */
         int totalWeight();
 
         /**
          * @brief Calculates the average distance between all pairs of vertices in the tree.
          * 
-         * This function uses the results from the Floyd-Warshall algorithm to calculate
-         * the average distance between all pairs of vertices that are reachable from each other.
+         * Pairs in different components of a forest are not counted.
          * 
-         * @return float The average distance between all pairs of vertices.
+         * @return float The average distance between all pairs of vertices, taken from computeMetrics.
          */
         float averageDistanceEdges();
 
         /**
          * @brief Calculates the diameter of the tree.
          * 
-         * The diameter of the tree is the longest shortest path between any two vertices.
-         * This function calculates the diameter by finding the farthest node from an arbitrary
-         * starting node, and then finding the farthest node from that node.
+         * The diameter of the tree is the longest shortest path between any two vertices. In a forest,
+         * it is the diameter of the component of vertex 1.
          * 
-         * @return int The diameter of the tree.
+         * @return int The diameter of the tree, taken from computeMetrics.
          */
         int diameter();
 
-  /**
- * @brief Finds the shortest path based on the least weighted edge in the tree.
- * 
- * This function automatically finds the least weighted edge in the tree and returns 
- * a formatted string representing the path between the two vertices connected by the 
- * least weighted edge and its total weight.
- * 
- * @return string A formatted string representing the shortest path and its total weight.
- */
-string shortestPath();
+        /**
+         * @brief Finds the shortest path based on the least weighted edge in the tree.
+         * 
+         * The least weighted edge is itself the path between its endpoints, so this formats it
+         * with its weight.
+         * 
+         * @return string The shortest path and its total weight, taken from computeMetrics.
+         */
+        string shortestPath();
+
+
+        /**
+         * @brief Returns the weighted distance between two vertices of the tree.
+         * 
+         * Answered in O(1) from the LCA index, which is built on the first query:
+         * rootDistance(u) + rootDistance(v) - 2 * rootDistance(lca(u, v)).
+         * 
+         * @param u The first vertex (1-based).
+         * @param v The second vertex (1-based).
+         * @return long long The total weight of the path, or -1 if a vertex is invalid or the
+         * vertices are in different components of a forest.
+         */
+        long long distance(int u, int v);
 
+        /**
+         * @brief Returns the vertices of the path between two vertices of the tree.
+         * 
+         * Both endpoints climb to their LCA through the index, so the cost is O(path length).
+         * 
+         * @param u The first vertex (1-based).
+         * @param v The second vertex (1-based).
+         * @return vector<int> The 1-based vertices from u to v, or an empty vector if there is no path.
+         */
+        vector<int> path(int u, int v);
 
         /**
-         * @brief Reconstructs the shortest path from source to destination.
+         * @brief Returns the weight of the heaviest edge on the path between two vertices of the tree.
+         * 
+         * This is the bottleneck (minimax) weight: no path in the original graph between u and v
+         * can avoid an edge this heavy. The path is split into O(log V) heavy chain ranges, each of
+         * which is one O(1) sparse table lookup.
          * 
-         * This function backtracks using the parent tracking vector to reconstruct the shortest
-         * path from the source to the destination vertex. It returns a formatted string that
-         * includes the path and its total weight.
+         * @param u The first vertex (1-based).
+         * @param v The second vertex (1-based).
+         * @return optional<int> The heaviest weight, or nullopt if u == v, a vertex is invalid or
+         * the vertices are in different components of a forest.
+         */
+        optional<int> bottleneck(int u, int v);
+
+        /**
+         * @brief Formats the path between two vertices of the tree.
          * 
-         * @param src The source vertex.
-         * @param dest The destination vertex.
-         * @param parentTrack The vector tracking the parent of each vertex.
-         * @param totalWeight The total weight of the path.
-         * @return string A formatted string representing the shortest path and its total weight.
+         * @param u The first vertex (1-based).
+         * @param v The second vertex (1-based).
+         * @return string The path as "u -> ... -> v (weight)" followed by a newline, or "No path" if there is none.
          */
-        string reconstructPath(int src, int dest, const vector<int> &parentTrack, int totalWeight);
+        string describePath(int u, int v);
 
         /**
          * @brief Adds an edge to the tree.
@@ -180,11 +307,32 @@ string shortestPath();
          * @brief Prints the minimum spanning tree (MST) in a structured format.
          * 
          * This function returns a string representation of the MST, where each node and its
-         * connections are indented to reflect the tree structure.
+         * connections are indented to reflect the tree structure. It is writeMST in the indented
+         * format collected into one string, and it is remembered until an edge is added.
          * 
          * @return string A formatted string representing the MST.
          */
         string printMST();
+
+        /**
+         * @brief Streams the edges of the tree to a writer, optionally one page at a time.
+         * 
+         * The edges are numbered in layout order, which is the DFS order of the old recursive
+         * printMST, and the edges offset .. offset + limit - 1 are written by a linear scan of the
+         * layout. The scan stops as soon as the page is complete or the writer fails.
+         * Text formats end with a "... showing edges a to b of E" line (or "... showing none of E
+         * edges") when the page is not the whole tree; the binary format starts with a
+         * "BINARY <count> <E>" line instead.
+         * Indentation grows with depth, so the indented format of a deep path is quadratic in
+         * its size; the flat and binary formats are linear.
+         * 
+         * @param out The writer that receives the output.
+         * @param format The layout to produce.
+         * @param offset The number of edges to skip.
+         * @param limit The largest number of edges to write, or -1 for no limit.
+         * @return int The number of edges in the page.
+         */
+        int writeMST(ChunkWriter& out, MSTFormat format, int offset = 0, int limit = -1);
 };
 
 #endif
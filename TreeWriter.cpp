@@ -0,0 +1,82 @@
+#include "TreeWriter.hpp"
+#include <algorithm>
+
+bool parseMSTFormat(const string& name, MSTFormat& format)
+{
+    if (name == "Indented")
+    {
+        format = MSTFormat::Indented;
+    }
+    else if (name == "Flat")
+    {
+        format = MSTFormat::Flat;
+    }
+    else if (name == "Binary")
+    {
+        format = MSTFormat::Binary;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+ChunkWriter::ChunkWriter(function<bool(const char*, size_t)> sink, size_t chunkSize)
+    : sink(move(sink)), chunkSize(chunkSize)
+{
+    buffer.reserve(chunkSize);
+}
+
+void ChunkWriter::write(const char* data, size_t size)
+{
+    while (size > 0 && !failed)
+    {
+        size_t part = min(size, chunkSize - buffer.size());
+        buffer.append(data, part);
+        data += part;
+        size -= part;
+        if (buffer.size() == chunkSize)
+        {
+            flush();
+        }
+    }
+}
+
+void ChunkWriter::fill(char c, size_t size)
+{
+    while (size > 0 && !failed)
+    {
+        size_t part = min(size, chunkSize - buffer.size());
+        buffer.append(part, c);
+        size -= part;
+        if (buffer.size() == chunkSize)
+        {
+            flush();
+        }
+    }
+}
+
+void ChunkWriter::writeInt32(int32_t value)
+{
+    uint32_t bits = static_cast<uint32_t>(value);
+    char bytes[4] = {static_cast<char>(bits), static_cast<char>(bits >> 8), static_cast<char>(bits >> 16), static_cast<char>(bits >> 24)};
+    write(bytes, sizeof(bytes));
+}
+
+bool ChunkWriter::flush()
+{
+    if (!failed && !buffer.empty())
+    {
+        if (sink(buffer.data(), buffer.size()))
+        {
+            written += buffer.size();
+        }
+        else
+        {
+            failed = true;
+        }
+    }
+    buffer.clear();
+    return !failed;
+}
@@ -0,0 +1,93 @@
+#ifndef TREEWRITER_HPP
+#define TREEWRITER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+using namespace std;
+
+/**
+ * @enum MSTFormat
+ *
+ * @brief The layouts Tree::writeMST can produce.
+ */
+enum class MSTFormat {
+    Indented, ///< The tree view of printMST, one indented line per edge
+    Flat,     ///< One "u v w" line per edge
+    Binary    ///< A "BINARY <count> <total>" line followed by count little-endian int32 triples (u, v, w)
+};
+
+/**
+ * @brief Parses a format name as used by the servers: "Indented", "Flat" or "Binary".
+ *
+ * @param name The name to parse
+ * @param format Set to the parsed format on success
+ * @return bool True if the name is a known format.
+ */
+bool parseMSTFormat(const string& name, MSTFormat& format);
+
+/**
+ * @class ChunkWriter
+ *
+ * @brief Buffers output and hands it to a sink in fixed-size chunks.
+ *
+ * Large outputs are produced piece by piece and leave through the sink as soon as a chunk
+ * is full, so they are never held in memory as a whole. Once the sink reports a failure
+ * (for example a closed socket) everything written afterwards is dropped and ok() turns false,
+ * which lets producers stop early.
+ */
+class ChunkWriter {
+    private:
+        function<bool(const char*, size_t)> sink; ///< Receives every full chunk, returns false on failure
+        string buffer; ///< Bytes not handed to the sink yet
+        size_t chunkSize; ///< Number of buffered bytes that triggers a flush
+        size_t written = 0; ///< Number of bytes accepted by the sink
+        bool failed = false; ///< True once the sink has failed
+
+    public:
+        /**
+         * @brief Creates a writer that flushes to sink every chunkSize bytes.
+         *
+         * @param sink The destination of the chunks
+         * @param chunkSize The size of a chunk in bytes
+         */
+        ChunkWriter(function<bool(const char*, size_t)> sink, size_t chunkSize = 1 << 16);
+
+        /**
+         * @brief Flushes whatever is still buffered.
+         */
+        ~ChunkWriter() { flush(); }
+
+        /**
+         * @brief Appends size bytes of data, flushing every time a chunk fills up.
+         */
+        void write(const char* data, size_t size);
+
+        void write(const string& text) { write(text.data(), text.size()); }
+
+        /**
+         * @brief Appends size copies of the character c.
+         */
+        void fill(char c, size_t size);
+
+        /**
+         * @brief Appends value as 4 little-endian bytes.
+         */
+        void writeInt32(int32_t value);
+
+        /**
+         * @brief Hands the buffered bytes to the sink.
+         *
+         * @return bool False if the sink has failed, now or before.
+         */
+        bool flush();
+
+        bool ok() const { return !failed; }
+
+        /**
+         * @brief Returns the number of bytes the sink has accepted so far.
+         */
+        size_t bytesWritten() const { return written; }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "UnionFind.hpp"
+
+UnionFind::UnionFind(int n): parent(n), size(n, 1), count(n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        parent[i] = i;
+    }
+}
+
+int UnionFind::uniteRoots(int rx, int ry)
+{
+    // Hang the smaller tree under the larger one
+    if (size[rx] < size[ry])
+    {
+        int tmp = rx;
+        rx = ry;
+        ry = tmp;
+    }
+    parent[ry] = rx;
+    size[rx] += size[ry];
+    count--;
+    return rx;
+}
+
+bool UnionFind::unite(int x, int y)
+{
+    int rx = find(x);
+    int ry = find(y);
+    if (rx == ry)
+    {
+        return false;
+    }
+    uniteRoots(rx, ry);
+    return true;
+}
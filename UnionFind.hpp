@@ -0,0 +1,76 @@
+#ifndef UNIONFIND_HPP
+#define UNIONFIND_HPP
+#include <vector>
+using namespace std;
+
+/*
+    UnionFind is a disjoint-set forest over the elements [0, n).
+    find is iterative and uses path halving, and sets are merged by size, so both
+    operations run in amortized inverse-Ackermann time without any recursion.
+    Callers that already hold the roots of two sets can merge them with uniteRoots
+    and skip the two extra finds.
+*/
+class UnionFind {
+    private:
+        vector<int> parent; // parent[x] == x for roots
+        vector<int> size;   // size[r] is the number of elements in the set of root r
+        int count;          // Number of disjoint sets
+
+    public:
+        UnionFind(int n);
+
+        /*
+        * @brief This method will find the representative of the set that contains the element x.
+        * Every visited element is re-pointed to its grandparent (path halving).
+        * @param x The element whose representative will be found.
+        * @return The representative of the set that contains the element x.
+        */
+        int find(int x)
+        {
+            while (parent[x] != x)
+            {
+                parent[x] = parent[parent[x]];
+                x = parent[x];
+            }
+            return x;
+        }
+
+        /*
+        * @brief This method will find the representative of the set that contains x without modifying the forest.
+        * It is safe to call concurrently from several threads as long as nobody modifies the forest.
+        * @param x The element whose representative will be found.
+        * @return The representative of the set that contains the element x.
+        */
+        int root(int x) const
+        {
+            while (parent[x] != x)
+            {
+                x = parent[x];
+            }
+            return x;
+        }
+
+        /*
+        * @brief This method will merge the sets whose representatives are rx and ry.
+        * @param rx The representative of the first set.
+        * @param ry The representative of the second set, different from rx.
+        * @return The representative of the merged set.
+        */
+        int uniteRoots(int rx, int ry);
+
+        /*
+        * @brief This method will unite the sets that contain the elements x and y.
+        * @param x The first element.
+        * @param y The second element.
+        * @return true if the sets were different and have been merged, false otherwise.
+        */
+        bool unite(int x, int y);
+
+        bool connected(int x, int y) { return find(x) == find(y); }
+
+        int setSize(int x) { return size[find(x)]; }
+
+        int sets() const { return count; }
+};
+
+#endif